@@ -0,0 +1,274 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace benchmark {
+
+State::State(int64_t iterations)
+    : iterations_(iterations) {}
+
+State::Iterator State::begin() {
+    ResumeTiming();
+    return { this, iterations_ };
+}
+
+State::Iterator State::end() {
+    return { this, 0 };
+}
+
+void State::PauseTiming() {
+    if (!running_) {
+        return;
+    }
+    real_seconds_ += chrono::duration<double>(Clock::now() - real_start_).count();
+    cpu_seconds_ += static_cast<double>(clock() - cpu_start_) / CLOCKS_PER_SEC;
+    running_ = false;
+}
+
+void State::ResumeTiming() {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    cpu_start_ = clock();
+    real_start_ = Clock::now();
+}
+
+int64_t State::iterations() const {
+    return iterations_;
+}
+
+void State::SetItemsProcessed(int64_t items) {
+    items_processed_ = items;
+}
+
+void State::SetCounter(const string& name, double value) {
+    counters_[name] = value;
+}
+
+double State::GetRealSeconds() const {
+    return real_seconds_;
+}
+
+double State::GetCpuSeconds() const {
+    return cpu_seconds_;
+}
+
+int64_t State::GetItemsProcessed() const {
+    return items_processed_;
+}
+
+const map<string, double>& State::GetCounters() const {
+    return counters_;
+}
+
+namespace {
+
+struct Benchmark {
+    string name;
+    Function function;
+};
+
+struct Result {
+    string name;
+    int64_t iterations;
+    double real_ns;
+    double cpu_ns;
+    double items_per_second;
+    map<string, double> counters;
+};
+
+vector<Benchmark>& Registry() {
+    static vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+Result Run(const Benchmark& benchmark, double min_time) {
+    const int64_t max_iterations = 1'000'000'000;
+    int64_t iterations = 1;
+    while (true) {
+        State state(iterations);
+        benchmark.function(state);
+        state.PauseTiming();
+        const double seconds = state.GetRealSeconds();
+        if (seconds >= min_time || iterations >= max_iterations) {
+            return { benchmark.name, iterations,
+                seconds * 1e9 / iterations, state.GetCpuSeconds() * 1e9 / iterations,
+                state.GetItemsProcessed() / max(seconds, 1e-12), state.GetCounters() };
+        }
+        const double predicted = iterations * min_time * 1.4 / max(seconds, 1e-9);
+        iterations = clamp(static_cast<int64_t>(predicted), iterations + 1, min(iterations * 10, max_iterations));
+    }
+}
+
+string FormatTime(double ns) {
+    ostringstream out;
+    out << fixed << setprecision(2);
+    if (ns < 1e3) {
+        out << ns << " ns";
+    }
+    else if (ns < 1e6) {
+        out << ns / 1e3 << " us";
+    }
+    else {
+        out << ns / 1e6 << " ms";
+    }
+    return out.str();
+}
+
+void PrintConsoleHeader(ostream& out) {
+    out << left << setw(56) << "Benchmark" << right << setw(14) << "Time" << setw(14) << "CPU"
+        << setw(12) << "Iterations" << "  Items/s" << endl;
+    out << string(110, '-') << endl;
+}
+
+void PrintConsole(ostream& out, const Result& result) {
+    out << left << setw(56) << result.name << right << setw(14) << FormatTime(result.real_ns)
+        << setw(14) << FormatTime(result.cpu_ns) << setw(12) << result.iterations;
+    if (result.items_per_second > 0) {
+        out << "  " << setprecision(4) << result.items_per_second;
+    }
+    for (const auto& [name, value] : result.counters) {
+        out << ' ' << name << '=' << value;
+    }
+    out << endl;
+}
+
+string EscapeJson(const string& text) {
+    string escaped;
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+// JSON has no NaN or infinity, so a counter dividing by zero prints as null
+void PrintJsonNumber(ostream& out, double value) {
+    if (isfinite(value)) {
+        out << value;
+    }
+    else {
+        out << "null";
+    }
+}
+
+void PrintJson(ostream& out, const string& executable, const vector<Result>& results) {
+    const time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+#ifdef NDEBUG
+    const char* build_type = "release";
+#else
+    const char* build_type = "debug";
+#endif
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"executable\": \"" << EscapeJson(executable) << "\",\n"
+        << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+        << "    \"library_build_type\": \"" << build_type << "\"\n"
+        << "  },\n  \"benchmarks\": [";
+    out << setprecision(17);
+    bool first = true;
+    for (const Result& result : results) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\n"
+            << "      \"name\": \"" << EscapeJson(result.name) << "\",\n"
+            << "      \"run_name\": \"" << EscapeJson(result.name) << "\",\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": ";
+        PrintJsonNumber(out, result.real_ns);
+        out << ",\n      \"cpu_time\": ";
+        PrintJsonNumber(out, result.cpu_ns);
+        out << ",\n      \"time_unit\": \"ns\"";
+        if (result.items_per_second > 0) {
+            out << ",\n      \"items_per_second\": ";
+            PrintJsonNumber(out, result.items_per_second);
+        }
+        for (const auto& [name, value] : result.counters) {
+            out << ",\n      \"" << EscapeJson(name) << "\": ";
+            PrintJsonNumber(out, value);
+        }
+        out << "\n    }";
+    }
+    out << "\n  ]\n}" << endl;
+}
+
+}  // namespace
+
+void RegisterBenchmark(const string& name, Function function) {
+    Registry().push_back({ name, move(function) });
+}
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        const auto value = [&arg](string_view prefix) {
+            return string(arg.substr(prefix.size()));
+        };
+        if (arg.starts_with("--benchmark_format=")) {
+            options.format = value("--benchmark_format=");
+        }
+        else if (arg.starts_with("--benchmark_out=")) {
+            options.out = value("--benchmark_out=");
+        }
+        else if (arg.starts_with("--benchmark_filter=")) {
+            options.filter = value("--benchmark_filter=");
+        }
+        else if (arg.starts_with("--benchmark_min_time=")) {
+            options.min_time = stod(value("--benchmark_min_time="));
+        }
+        else {
+            throw invalid_argument("Unknown option " + string(arg));
+        }
+    }
+    if (options.format != "console" && options.format != "json") {
+        throw invalid_argument("Unknown benchmark format " + options.format);
+    }
+    return options;
+}
+
+int RunRegisteredBenchmarks(const Options& options, const string& executable) {
+    const regex filter(options.filter.empty() ? ".*" : options.filter);
+    const bool console = options.format == "console";
+    if (console) {
+        PrintConsoleHeader(cout);
+    }
+    vector<Result> results;
+    for (const Benchmark& benchmark : Registry()) {
+        if (!regex_search(benchmark.name, filter)) {
+            continue;
+        }
+        results.push_back(Run(benchmark, options.min_time));
+        if (console) {
+            PrintConsole(cout, results.back());
+        }
+    }
+    if (!console) {
+        PrintJson(cout, executable, results);
+    }
+    if (!options.out.empty()) {
+        ofstream out(options.out);
+        if (!out) {
+            cerr << "Cannot open " << options.out << endl;
+            return 1;
+        }
+        PrintJson(out, executable, results);
+    }
+    return 0;
+}
+
+}  // namespace benchmark
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+class State {
+public:
+    // The loop variable of for (auto _ : state); GCC does not flag unused variables whose type has a user-provided
+    // destructor, so the loops compile without warnings
+    struct Value {
+        ~Value() {}
+    };
+
+    class Iterator {
+    public:
+        Iterator(State* state, int64_t remaining)
+            : state_(state), remaining_(remaining) {}
+
+        Value operator*() const {
+            return {};
+        }
+
+        Iterator& operator++() {
+            --remaining_;
+            return *this;
+        }
+
+        bool operator!=(const Iterator&) {
+            if (remaining_ > 0) {
+                return true;
+            }
+            state_->PauseTiming();
+            return false;
+        }
+
+    private:
+        State* state_;
+        int64_t remaining_;
+    };
+
+    explicit State(int64_t iterations);
+
+    Iterator begin();
+    Iterator end();
+
+    void PauseTiming();
+    void ResumeTiming();
+
+    int64_t iterations() const;
+    void SetItemsProcessed(int64_t items);
+    void SetCounter(const std::string& name, double value);
+
+    double GetRealSeconds() const;
+    double GetCpuSeconds() const;
+    int64_t GetItemsProcessed() const;
+    const std::map<std::string, double>& GetCounters() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int64_t iterations_;
+    int64_t items_processed_ = 0;
+    std::map<std::string, double> counters_;
+    bool running_ = false;
+    Clock::time_point real_start_;
+    std::clock_t cpu_start_ = 0;
+    double real_seconds_ = 0;
+    double cpu_seconds_ = 0;
+};
+
+using Function = std::function<void(State&)>;
+
+void RegisterBenchmark(const std::string& name, Function function);
+
+struct Options {
+    std::string format = "console";
+    std::string out;
+    std::string filter;
+    double min_time = 0.5;
+};
+
+Options ParseOptions(int argc, char** argv);
+
+int RunRegisteredBenchmarks(const Options& options, const std::string& executable);
+
+}  // namespace benchmark
@@ -0,0 +1,107 @@
+#include "corpus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+using namespace std;
+
+ZipfDistribution::ZipfDistribution(int size, double exponent) {
+    cumulative_.reserve(size);
+    double sum = 0;
+    for (int rank = 1; rank <= size; ++rank) {
+        sum += 1.0 / pow(rank, exponent);
+        cumulative_.push_back(sum);
+    }
+    for (double& value : cumulative_) {
+        value /= sum;
+    }
+}
+
+int ZipfDistribution::operator()(mt19937& generator) const {
+    const double value = uniform_real_distribution<>(0, 1)(generator);
+    const auto it = upper_bound(cumulative_.begin(), cumulative_.end(), value);
+    return static_cast<int>(min(it - cumulative_.begin(), static_cast<ptrdiff_t>(cumulative_.size()) - 1));
+}
+
+static vector<string> GenerateVocabulary(mt19937& generator, int word_count, int max_length) {
+    unordered_set<string> seen;
+    vector<string> words;
+    words.reserve(word_count);
+    while (static_cast<int>(words.size()) < word_count) {
+        const int length = uniform_int_distribution(1, max_length)(generator);
+        string word;
+        for (int i = 0; i < length; ++i) {
+            word.push_back(uniform_int_distribution('a', 'z')(generator));
+        }
+        if (seen.insert(word).second) {
+            words.push_back(move(word));
+        }
+    }
+    return words;
+}
+
+Corpus::Corpus(const CorpusOptions& options)
+    : options_(options), word_distribution_(options.vocabulary_size, options.zipf_exponent) {
+    mt19937 generator(options.seed);
+    vocabulary_ = GenerateVocabulary(generator, options.vocabulary_size, options.max_word_length);
+    documents_.reserve(options.document_count);
+    for (int i = 0; i < options.document_count; ++i) {
+        if (!documents_.empty() && uniform_real_distribution<>(0, 1)(generator) < options.duplicate_ratio) {
+            documents_.push_back(documents_[uniform_int_distribution<size_t>(0, documents_.size() - 1)(generator)]);
+            continue;
+        }
+        string document;
+        for (int j = 0; j < options.words_per_document; ++j) {
+            if (!document.empty()) {
+                document.push_back(' ');
+            }
+            document += vocabulary_[word_distribution_(generator)];
+        }
+        documents_.push_back(move(document));
+    }
+}
+
+const vector<string>& Corpus::GetVocabulary() const {
+    return vocabulary_;
+}
+
+const vector<string>& Corpus::GetDocuments() const {
+    return documents_;
+}
+
+string Corpus::GetStopWords() const {
+    string stop_words;
+    for (int i = 0; i < min(options_.stop_word_count, options_.vocabulary_size); ++i) {
+        stop_words += vocabulary_[i] + ' ';
+    }
+    return stop_words;
+}
+
+vector<string> Corpus::GenerateQueries(int query_count, int words_per_query, double minus_ratio, unsigned seed) const {
+    mt19937 generator(seed);
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        string query;
+        for (int j = 0; j < words_per_query; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            if (uniform_real_distribution<>(0, 1)(generator) < minus_ratio) {
+                query.push_back('-');
+            }
+            query += vocabulary_[word_distribution_(generator)];
+        }
+        queries.push_back(move(query));
+    }
+    return queries;
+}
+
+void Corpus::Fill(SearchServer& search_server) const {
+    for (size_t i = 0; i < documents_.size(); ++i) {
+        const int id = static_cast<int>(i);
+        const DocumentStatus status = i % 10 == 0 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id, documents_[i], status, { id % 7, id % 5 + 1, 3 });
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+class ZipfDistribution {
+public:
+    ZipfDistribution(int size, double exponent);
+
+    int operator()(std::mt19937& generator) const;
+
+private:
+    std::vector<double> cumulative_;
+};
+
+struct CorpusOptions {
+    int vocabulary_size = 20'000;
+    int max_word_length = 10;
+    double zipf_exponent = 1.0;
+    int stop_word_count = 5;
+    int document_count = 10'000;
+    int words_per_document = 70;
+    double duplicate_ratio = 0.0;
+    unsigned seed = 42;
+};
+
+class Corpus {
+public:
+    explicit Corpus(const CorpusOptions& options);
+
+    const std::vector<std::string>& GetVocabulary() const;
+    const std::vector<std::string>& GetDocuments() const;
+    std::string GetStopWords() const;
+
+    std::vector<std::string> GenerateQueries(int query_count, int words_per_query, double minus_ratio, unsigned seed) const;
+    void Fill(SearchServer& search_server) const;
+
+private:
+    CorpusOptions options_;
+    std::vector<std::string> vocabulary_;
+    std::vector<std::string> documents_;
+    ZipfDistribution word_distribution_;
+};
@@ -0,0 +1,279 @@
+#include "benchmark.h"
+#include "corpus.h"
+#include "process_queries.h"
+#include "query_profile.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "term_dictionary.h"
+
+#include <execution>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using benchmark::State;
+
+const Corpus& GetCorpus() {
+    static const Corpus corpus(CorpusOptions{});
+    return corpus;
+}
+
+const SearchServer& GetSearchServer() {
+    static const SearchServer search_server = [] {
+        SearchServer server(GetCorpus().GetStopWords());
+        GetCorpus().Fill(server);
+        return server;
+    }();
+    return search_server;
+}
+
+unique_ptr<SearchServer> MakeSearchServer(const Corpus& corpus, int document_count) {
+    auto search_server = make_unique<SearchServer>(corpus.GetStopWords());
+    const auto& documents = corpus.GetDocuments();
+    for (int id = 0; id < document_count; ++id) {
+        search_server->AddDocument(id, documents[id], DocumentStatus::ACTUAL, { id % 7, 3 });
+    }
+    return search_server;
+}
+
+void BenchmarkAddDocument(State& state, int document_count) {
+    for (auto _ : state) {
+        auto search_server = MakeSearchServer(GetCorpus(), document_count);
+        state.PauseTiming();
+        search_server.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * document_count);
+}
+
+template <typename ExecutionPolicy>
+void BenchmarkRemoveDocument(State& state, const ExecutionPolicy& policy, int document_count) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto search_server = MakeSearchServer(GetCorpus(), document_count);
+        state.ResumeTiming();
+        for (int id = 0; id < document_count; ++id) {
+            search_server->RemoveDocument(policy, id);
+        }
+        state.PauseTiming();
+        search_server.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * document_count);
+}
+
+void BenchmarkMatchDocument(State& state, int words_per_query, double minus_ratio) {
+    const SearchServer& search_server = GetSearchServer();
+    const auto queries = GetCorpus().GenerateQueries(100, words_per_query, minus_ratio, 1);
+    const int document_count = search_server.GetDocumentCount();
+    size_t matched_words = 0;
+    int64_t i = 0;
+    for (auto _ : state) {
+        const auto [words, status] = search_server.MatchDocument(queries[i % queries.size()],
+            static_cast<int>(i % document_count));
+        matched_words += words.size();
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetCounter("matched_words", static_cast<double>(matched_words) / state.iterations());
+}
+
+template <typename ExecutionPolicy>
+void BenchmarkFindTopDocuments(State& state, const ExecutionPolicy& policy, int words_per_query, double minus_ratio) {
+    const SearchServer& search_server = GetSearchServer();
+    const auto queries = GetCorpus().GenerateQueries(100, words_per_query, minus_ratio, 2);
+    size_t found = 0;
+    int64_t i = 0;
+    for (auto _ : state) {
+        found += search_server.FindTopDocuments(policy, queries[i++ % queries.size()]).size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetCounter("found", static_cast<double>(found) / state.iterations());
+}
+
+CorpusOptions MakeVocabularyOptions(int vocabulary_size) {
+    CorpusOptions options;
+    options.vocabulary_size = vocabulary_size;
+    options.document_count = 0;
+    return options;
+}
+
+struct TermExpansionFixture {
+    explicit TermExpansionFixture(int vocabulary_size)
+        : corpus(MakeVocabularyOptions(vocabulary_size)) {
+        for (const string& word : corpus.GetVocabulary()) {
+            dictionary.Add(word);
+        }
+    }
+
+    const Corpus corpus;
+    TermDictionary dictionary;
+};
+
+// Built once per vocabulary size: every Run call of every expansion benchmark shares it
+const TermExpansionFixture& GetTermExpansionFixture(int vocabulary_size) {
+    static map<int, unique_ptr<TermExpansionFixture>> fixtures;
+    auto& fixture = fixtures[vocabulary_size];
+    if (!fixture) {
+        fixture = make_unique<TermExpansionFixture>(vocabulary_size);
+    }
+    return *fixture;
+}
+
+void BenchmarkTermExpansion(State& state, int vocabulary_size, int max_edits) {
+    const TermExpansionFixture& fixture = GetTermExpansionFixture(vocabulary_size);
+    const TermDictionary& dictionary = fixture.dictionary;
+    const auto& vocabulary = fixture.corpus.GetVocabulary();
+    size_t expanded = 0;
+    size_t cut = 0;
+    int64_t i = 0;
+    for (auto _ : state) {
+        const string& word = vocabulary[(i++ * 7919) % vocabulary.size()];
+        size_t count = 0;
+        const auto visitor = [&count](int, auto...) {
+            return ++count < MAX_QUERY_TERM_EXPANSIONS;
+        };
+        if (max_edits == 0) {
+            dictionary.ForEachWithPrefix(string_view(word).substr(0, 3), visitor);
+        }
+        else if (!dictionary.ForEachWithinDistance(word, max_edits, visitor, MAX_QUERY_FUZZY_STEPS)) {
+            ++cut;
+        }
+        expanded += count;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetCounter("expanded", static_cast<double>(expanded) / state.iterations());
+    state.SetCounter("cut", static_cast<double>(cut) / state.iterations());
+}
+
+void BenchmarkExpandedQueries(State& state, const string& operator_suffix) {
+    const SearchServer& search_server = GetSearchServer();
+    auto queries = GetCorpus().GenerateQueries(100, 3, 0.0, 4);
+    for (string& query : queries) {
+        string expanded;
+        istringstream words(query);
+        for (string word; words >> word;) {
+            expanded += word + operator_suffix + ' ';
+        }
+        query = move(expanded);
+    }
+    size_t found = 0;
+    int64_t i = 0;
+    for (auto _ : state) {
+        found += search_server.FindTopDocuments(queries[i++ % queries.size()]).size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetCounter("found", static_cast<double>(found) / state.iterations());
+}
+
+void BenchmarkProcessQueries(State& state, int query_count, int words_per_query) {
+    const SearchServer& search_server = GetSearchServer();
+    const auto queries = GetCorpus().GenerateQueries(query_count, words_per_query, 0.1, 3);
+    for (auto _ : state) {
+        const auto results = ProcessQueries(search_server, queries);
+        if (results.size() != queries.size()) {
+            throw logic_error("ProcessQueries lost results");
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * query_count);
+}
+
+void BenchmarkRemoveDuplicates(State& state, int document_count, double duplicate_ratio) {
+    CorpusOptions options;
+    options.document_count = document_count;
+    options.duplicate_ratio = duplicate_ratio;
+    const Corpus corpus(options);
+    ostringstream sink;
+    auto* const cout_buffer = cout.rdbuf(sink.rdbuf());
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto search_server = MakeSearchServer(corpus, document_count);
+        sink.str({});
+        state.ResumeTiming();
+        RemoveDuplicates(*search_server);
+        state.PauseTiming();
+        search_server.reset();
+        state.ResumeTiming();
+    }
+    cout.rdbuf(cout_buffer);
+    state.SetItemsProcessed(state.iterations() * document_count);
+}
+
+string FormatRatio(double ratio) {
+    ostringstream out;
+    out << ratio;
+    return out.str();
+}
+
+void RegisterBenchmarks() {
+    using benchmark::RegisterBenchmark;
+
+    for (const int document_count : { 1'000, 10'000 }) {
+        RegisterBenchmark("AddDocument/docs:" + to_string(document_count), [=](State& state) {
+            BenchmarkAddDocument(state, document_count);
+            });
+    }
+    RegisterBenchmark("RemoveDocument/seq/docs:1000", [](State& state) {
+        BenchmarkRemoveDocument(state, execution::seq, 1'000);
+        });
+    RegisterBenchmark("RemoveDocument/par/docs:1000", [](State& state) {
+        BenchmarkRemoveDocument(state, execution::par, 1'000);
+        });
+    for (const int words : { 3, 10, 70 }) {
+        RegisterBenchmark("MatchDocument/words:" + to_string(words), [=](State& state) {
+            BenchmarkMatchDocument(state, words, 0.1);
+            });
+    }
+    for (const int words : { 3, 10, 70 }) {
+        for (const double minus_ratio : { 0.0, 0.1, 0.3 }) {
+            const string suffix = "/words:" + to_string(words) + "/minus:" + FormatRatio(minus_ratio);
+            RegisterBenchmark("FindTopDocuments/seq" + suffix, [=](State& state) {
+                BenchmarkFindTopDocuments(state, execution::seq, words, minus_ratio);
+                });
+            RegisterBenchmark("FindTopDocuments/par" + suffix, [=](State& state) {
+                BenchmarkFindTopDocuments(state, execution::par, words, minus_ratio);
+                });
+        }
+    }
+    RegisterBenchmark("TermExpansion/prefix/terms:1000000", [](State& state) {
+        BenchmarkTermExpansion(state, 1'000'000, 0);
+        });
+    for (const int max_edits : { 1, 2 }) {
+        RegisterBenchmark("TermExpansion/fuzzy:" + to_string(max_edits) + "/terms:1000000", [=](State& state) {
+            BenchmarkTermExpansion(state, 1'000'000, max_edits);
+            });
+    }
+    RegisterBenchmark("FindTopDocuments/seq/words:3/prefix", [](State& state) {
+        BenchmarkExpandedQueries(state, "*");
+        });
+    RegisterBenchmark("FindTopDocuments/seq/words:3/fuzzy:1", [](State& state) {
+        BenchmarkExpandedQueries(state, "~1");
+        });
+    for (const int query_count : { 100, 1'000 }) {
+        RegisterBenchmark("ProcessQueries/queries:" + to_string(query_count) + "/words:10", [=](State& state) {
+            BenchmarkProcessQueries(state, query_count, 10);
+            });
+    }
+    RegisterBenchmark("RemoveDuplicates/docs:2000/dup:0.2", [](State& state) {
+        BenchmarkRemoveDuplicates(state, 2'000, 0.2);
+        });
+}
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = benchmark::ParseOptions(argc, argv);
+        RegisterBenchmarks();
+        const int result = benchmark::RunRegisteredBenchmarks(options, argv[0]);
+#ifdef SEARCH_SERVER_PROFILING
+        TakeQueryProfileSnapshot().PrintText(cerr);
+#endif
+        return result;
+    }
+    catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,47 @@
+#include "allocation_counter.h"
+
+using namespace std;
+
+AllocationCounter::AllocationCounter(pmr::memory_resource* upstream)
+    : upstream_(upstream) {}
+
+size_t AllocationCounter::GetAllocationCount() const {
+    return allocation_count_.load(memory_order_relaxed);
+}
+
+size_t AllocationCounter::GetDeallocationCount() const {
+    return deallocation_count_.load(memory_order_relaxed);
+}
+
+size_t AllocationCounter::GetBytesAllocated() const {
+    return bytes_allocated_.load(memory_order_relaxed);
+}
+
+size_t AllocationCounter::GetBytesInUse() const {
+    return bytes_in_use_.load(memory_order_relaxed);
+}
+
+size_t AllocationCounter::GetPeakBytesInUse() const {
+    return peak_bytes_in_use_.load(memory_order_relaxed);
+}
+
+void* AllocationCounter::do_allocate(size_t bytes, size_t alignment) {
+    void* p = upstream_->allocate(bytes, alignment);
+    allocation_count_.fetch_add(1, memory_order_relaxed);
+    bytes_allocated_.fetch_add(bytes, memory_order_relaxed);
+    const size_t in_use = bytes_in_use_.fetch_add(bytes, memory_order_relaxed) + bytes;
+    size_t peak = peak_bytes_in_use_.load(memory_order_relaxed);
+    while (in_use > peak && !peak_bytes_in_use_.compare_exchange_weak(peak, in_use, memory_order_relaxed)) {
+    }
+    return p;
+}
+
+void AllocationCounter::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream_->deallocate(p, bytes, alignment);
+    deallocation_count_.fetch_add(1, memory_order_relaxed);
+    bytes_in_use_.fetch_sub(bytes, memory_order_relaxed);
+}
+
+bool AllocationCounter::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
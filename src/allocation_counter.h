@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+class AllocationCounter : public std::pmr::memory_resource {
+public:
+    explicit AllocationCounter(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    size_t GetAllocationCount() const;
+    size_t GetDeallocationCount() const;
+    size_t GetBytesAllocated() const;
+    size_t GetBytesInUse() const;
+    size_t GetPeakBytesInUse() const;
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::atomic<size_t> allocation_count_ = 0;
+    std::atomic<size_t> deallocation_count_ = 0;
+    std::atomic<size_t> bytes_allocated_ = 0;
+    std::atomic<size_t> bytes_in_use_ = 0;
+    std::atomic<size_t> peak_bytes_in_use_ = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
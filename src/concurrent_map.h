@@ -1,47 +1,226 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <execution>
+#include <functional>
 #include <map>
-#include <vector>
 #include <mutex>
-#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+constexpr size_t CACHE_LINE_SIZE = 64;
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
 class ConcurrentMap {
 public:
-
-    static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
+    static_assert(std::is_default_constructible_v<Key> && std::is_default_constructible_v<Value>,
+        "ConcurrentMap stores keys and values in preallocated slots");
 
     struct Access {
         std::lock_guard<std::mutex> guard;
         Value& ref_to_value;
     };
 
-    explicit ConcurrentMap(size_t bucket_count) : concurrent_map_(bucket_count) {}
+    ConcurrentMap()
+        : ConcurrentMap(std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4) {}
+
+    explicit ConcurrentMap(size_t shard_count)
+        : shards_(std::bit_ceil(std::max<size_t>(shard_count, 1))) {}
 
     Access operator[](const Key& key) {
-        auto& bucket_for_return = concurrent_map_[static_cast<uint64_t>(key) % concurrent_map_.size()];
-        return { std::lock_guard(bucket_for_return.mut), bucket_for_return.sub_map[key] };
+        const size_t hash = GetHash(key);
+        Shard& shard = GetShard(hash);
+        std::unique_lock lock(shard.mutex);
+        Value& value = shard.table.FindOrInsert(key, hash);
+        lock.release();
+        return { std::lock_guard(shard.mutex, std::adopt_lock), value };
     }
 
-    std::map<Key, Value> BuildOrdinaryMap() {
-        std::map<Key, Value> result;
-        for (auto& [mutex, map] : concurrent_map_) {
-            std::lock_guard g(mutex);
-            result.insert(map.begin(), map.end());
+    template <typename Updater>
+    void Update(const Key& key, Updater updater) {
+        const size_t hash = GetHash(key);
+        Shard& shard = GetShard(hash);
+        std::lock_guard guard(shard.mutex);
+        updater(shard.table.FindOrInsert(key, hash));
+    }
+
+    // Takes the shard lock like Update: slots move on rehash, so a value is never safe to touch without it
+    void Add(const Key& key, const Value& delta) {
+        static_assert(std::is_arithmetic_v<Value>, "Add needs an arithmetic value type");
+        Update(key, [&delta](Value& value) {
+            value += delta;
+            });
+    }
+
+    size_t erase(const Key& key) {
+        const size_t hash = GetHash(key);
+        Shard& shard = GetShard(hash);
+        std::lock_guard guard(shard.mutex);
+        return shard.table.Erase(key, hash) ? 1 : 0;
+    }
+
+    size_t size() const {
+        size_t result = 0;
+        for (const Shard& shard : shards_) {
+            std::lock_guard guard(shard.mutex);
+            result += shard.table.size();
+        }
+        return result;
+    }
+
+    template <typename ExecutionPolicy, typename Function>
+    void ForEach(const ExecutionPolicy& policy, Function function) const {
+        std::for_each(policy, shards_.begin(), shards_.end(), [&function](const Shard& shard) {
+            std::lock_guard guard(shard.mutex);
+            shard.table.ForEach(function);
+            });
+    }
+
+    std::vector<std::pair<Key, Value>> Extract() {
+        std::vector<std::pair<Key, Value>> result;
+        for (Shard& shard : shards_) {
+            std::lock_guard guard(shard.mutex);
+            result.reserve(result.size() + shard.table.size());
+            shard.table.ForEach([&result](const Key& key, Value& value) {
+                result.emplace_back(key, std::move(value));
+                });
+            shard.table = {};
         }
         return result;
     }
 
-    void erase(const Key& key) {
-        auto& bucket_for_erase = concurrent_map_[static_cast<uint64_t>(key) % concurrent_map_.size()];
-        std::lock_guard g(bucket_for_erase.mut);
-        bucket_for_erase.sub_map.erase(key);
+    std::map<Key, Value> BuildOrdinaryMap() {
+        std::map<Key, Value> result;
+        ForEach(std::execution::seq, [&result](const Key& key, const Value& value) {
+            result.emplace(key, value);
+            });
+        return result;
     }
+
 private:
-    struct Bucket {
-        std::mutex mut;
-        std::map<Key, Value> sub_map;
+    // Linear probing over a power-of-two slot array; erased slots become tombstones until the next rehash
+    class Table {
+    public:
+        Value& FindOrInsert(const Key& key, size_t hash) {
+            if ((size_ + tombstones_ + 1) * 4 > states_.size() * 3) {
+                Rehash(std::max<size_t>(std::bit_ceil((size_ + 1) * 2), 8));
+            }
+            const size_t mask = states_.size() - 1;
+            size_t insert_position = states_.size();
+            for (size_t position = hash & mask;; position = (position + 1) & mask) {
+                if (states_[position] == State::FULL) {
+                    if (KeyEqual{}(slots_[position].first, key)) {
+                        return slots_[position].second;
+                    }
+                    continue;
+                }
+                if (states_[position] == State::DELETED) {
+                    insert_position = std::min(insert_position, position);
+                    continue;
+                }
+                if (insert_position == states_.size()) {
+                    insert_position = position;
+                }
+                break;
+            }
+            if (states_[insert_position] == State::DELETED) {
+                --tombstones_;
+            }
+            states_[insert_position] = State::FULL;
+            slots_[insert_position] = { key, Value{} };
+            ++size_;
+            return slots_[insert_position].second;
+        }
+
+        bool Erase(const Key& key, size_t hash) {
+            if (size_ == 0) {
+                return false;
+            }
+            const size_t mask = states_.size() - 1;
+            for (size_t position = hash & mask; states_[position] != State::EMPTY; position = (position + 1) & mask) {
+                if (states_[position] == State::FULL && KeyEqual{}(slots_[position].first, key)) {
+                    states_[position] = State::DELETED;
+                    slots_[position] = {};
+                    --size_;
+                    ++tombstones_;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template <typename Function>
+        void ForEach(Function&& function) const {
+            for (size_t position = 0; position < states_.size(); ++position) {
+                if (states_[position] == State::FULL) {
+                    function(slots_[position].first, slots_[position].second);
+                }
+            }
+        }
+
+        template <typename Function>
+        void ForEach(Function&& function) {
+            for (size_t position = 0; position < states_.size(); ++position) {
+                if (states_[position] == State::FULL) {
+                    function(slots_[position].first, slots_[position].second);
+                }
+            }
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+    private:
+        enum class State : uint8_t {
+            EMPTY,
+            FULL,
+            DELETED,
+        };
+
+        std::vector<State> states_;
+        std::vector<std::pair<Key, Value>> slots_;
+        size_t size_ = 0;
+        size_t tombstones_ = 0;
+
+        void Rehash(size_t capacity) {
+            std::vector<State> states(capacity, State::EMPTY);
+            std::vector<std::pair<Key, Value>> slots(capacity);
+            const size_t mask = capacity - 1;
+            for (size_t position = 0; position < states_.size(); ++position) {
+                if (states_[position] != State::FULL) {
+                    continue;
+                }
+                size_t target = GetHash(slots_[position].first) & mask;
+                while (states[target] == State::FULL) {
+                    target = (target + 1) & mask;
+                }
+                states[target] = State::FULL;
+                slots[target] = std::move(slots_[position]);
+            }
+            states_ = std::move(states);
+            slots_ = std::move(slots);
+            tombstones_ = 0;
+        }
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        mutable std::mutex mutex;
+        Table table;
     };
 
-    std::vector<Bucket> concurrent_map_;
+    std::vector<Shard> shards_;
+
+    static size_t GetHash(const Key& key) {
+        // Fibonacci mixing spreads identity hashes such as std::hash<int> over all bits
+        return static_cast<size_t>(static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull);
+    }
+
+    Shard& GetShard(size_t hash) {
+        return shards_[(hash >> 32) & (shards_.size() - 1)];
+    }
 };
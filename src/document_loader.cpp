@@ -0,0 +1,449 @@
+#include "document_loader.h"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+double LoadStats::GetDocumentsPerSecond() const {
+    return seconds > 0 ? documents / seconds : 0.0;
+}
+
+double LoadStats::GetMegabytesPerSecond() const {
+    return seconds > 0 ? bytes / seconds / (1 << 20) : 0.0;
+}
+
+ostream& operator<<(ostream& out, const LoadStats& stats) {
+    return out << "{ documents = "s << stats.documents <<
+        ", bytes = "s << stats.bytes <<
+        ", seconds = "s << stats.seconds <<
+        ", documents/s = "s << stats.GetDocumentsPerSecond() <<
+        ", MB/s = "s << stats.GetMegabytesPerSecond() << " }"s;
+}
+
+namespace {
+
+struct Batch {
+    string storage;
+    string_view text;
+    size_t line_count = 0;
+    vector<SearchServer::PreparedDocument> documents;
+    vector<size_t> document_lines;
+    optional<pair<size_t, string>> error;
+};
+
+class ChunkSource {
+public:
+    virtual ~ChunkSource() = default;
+    // Fills batch.text with whole lines; returns false once the input is exhausted
+    virtual bool Next(Batch& batch) = 0;
+};
+
+class StreamSource : public ChunkSource {
+public:
+    StreamSource(istream& input, size_t batch_bytes)
+        : input_(input), batch_bytes_(batch_bytes) {}
+
+    bool Next(Batch& batch) override {
+        string& storage = batch.storage;
+        storage = move(carry_);
+        carry_.clear();
+        size_t search_from = 0;
+        while (input_) {
+            const size_t old_size = storage.size();
+            storage.resize(old_size + batch_bytes_);
+            input_.read(storage.data() + old_size, batch_bytes_);
+            storage.resize(old_size + input_.gcount());
+            if (!input_) {
+                break;
+            }
+            const size_t last_newline = storage.rfind('\n');
+            if (last_newline != string::npos && last_newline >= search_from) {
+                carry_.assign(storage, last_newline + 1);
+                storage.resize(last_newline + 1);
+                break;
+            }
+            search_from = storage.size();
+        }
+        if (input_.bad()) {
+            throw runtime_error("Failed to read documents from stream");
+        }
+        batch.text = storage;
+        return !storage.empty();
+    }
+
+private:
+    istream& input_;
+    size_t batch_bytes_;
+    string carry_;
+};
+
+class MappedFileSource : public ChunkSource {
+public:
+    MappedFileSource(const string& path, size_t batch_bytes)
+        : batch_bytes_(batch_bytes) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open " + path + ": " + strerror(errno));
+        }
+        struct stat file_stat {};
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            throw runtime_error("Cannot stat " + path + ": " + strerror(errno));
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Cannot map " + path + ": " + strerror(errno));
+            }
+            madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+        close(fd);
+    }
+
+    MappedFileSource(const MappedFileSource&) = delete;
+    MappedFileSource& operator=(const MappedFileSource&) = delete;
+
+    ~MappedFileSource() override {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    bool Next(Batch& batch) override {
+        if (position_ >= size_) {
+            return false;
+        }
+        size_t end = min(position_ + batch_bytes_, size_);
+        if (end < size_) {
+            const void* newline = memchr(data_ + end - 1, '\n', size_ - end + 1);
+            end = newline ? static_cast<const char*>(newline) - data_ + 1 : size_;
+        }
+        batch.text = string_view(data_ + position_, end - position_);
+        position_ = end;
+        return true;
+    }
+
+private:
+    size_t batch_bytes_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+};
+
+template <typename T>
+class BlockingQueue {
+public:
+    void Push(T value) {
+        {
+            lock_guard g(mutex_);
+            items_.push_back(move(value));
+        }
+        condition_.notify_one();
+    }
+
+    optional<T> Pop() {
+        unique_lock lock(mutex_);
+        condition_.wait(lock, [this] {
+            return !items_.empty() || closed_;
+        });
+        if (items_.empty()) {
+            return nullopt;
+        }
+        T value = move(items_.front());
+        items_.pop_front();
+        return value;
+    }
+
+    void Close() {
+        {
+            lock_guard g(mutex_);
+            closed_ = true;
+        }
+        condition_.notify_all();
+    }
+
+private:
+    mutex mutex_;
+    condition_variable condition_;
+    deque<T> items_;
+    bool closed_ = false;
+};
+
+// Hands batches to the inserting thread in read order, whatever order the tokenizers finish them in
+class ReorderBuffer {
+public:
+    void Put(size_t sequence, unique_ptr<Batch> batch) {
+        {
+            lock_guard g(mutex_);
+            ready_.emplace(sequence, move(batch));
+        }
+        condition_.notify_all();
+    }
+
+    void Finish(size_t batch_count) {
+        {
+            lock_guard g(mutex_);
+            batch_count_ = batch_count;
+        }
+        condition_.notify_all();
+    }
+
+    unique_ptr<Batch> Take(size_t sequence) {
+        unique_lock lock(mutex_);
+        condition_.wait(lock, [this, sequence] {
+            return ready_.count(sequence) || sequence >= batch_count_;
+        });
+        const auto it = ready_.find(sequence);
+        if (it == ready_.end()) {
+            return nullptr;
+        }
+        unique_ptr<Batch> batch = move(it->second);
+        ready_.erase(it);
+        return batch;
+    }
+
+private:
+    mutex mutex_;
+    condition_variable condition_;
+    map<size_t, unique_ptr<Batch>> ready_;
+    size_t batch_count_ = SIZE_MAX;
+};
+
+template <typename Number>
+Number ParseNumber(string_view text, const char* what) {
+    Number value{};
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc() || end != text.data() + text.size()) {
+        throw invalid_argument("Invalid "s + what + " '" + string(text) + "'");
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(string_view text) {
+    static const map<string_view, DocumentStatus> statuses = {
+        { "ACTUAL", DocumentStatus::ACTUAL },
+        { "IRRELEVANT", DocumentStatus::IRRELEVANT },
+        { "BANNED", DocumentStatus::BANNED },
+        { "REMOVED", DocumentStatus::REMOVED },
+    };
+    if (const auto it = statuses.find(text); it != statuses.end()) {
+        return it->second;
+    }
+    const int value = ParseNumber<int>(text, "document status");
+    if (value < 0 || value > static_cast<int>(DocumentStatus::REMOVED)) {
+        throw invalid_argument("Invalid document status '" + string(text) + "'");
+    }
+    return static_cast<DocumentStatus>(value);
+}
+
+string_view TakeField(string_view& line) {
+    const size_t tab = line.find('\t');
+    if (tab == string_view::npos) {
+        throw invalid_argument("Expected id, status, ratings and text separated by tabs");
+    }
+    const string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+SearchServer::PreparedDocument ParseLine(const SearchServer& search_server, string_view line) {
+    const int document_id = ParseNumber<int>(TakeField(line), "document id");
+    const DocumentStatus status = ParseStatus(TakeField(line));
+    string_view ratings_text = TakeField(line);
+    vector<int> ratings;
+    while (!ratings_text.empty()) {
+        const size_t space = ratings_text.find(' ');
+        const string_view rating = ratings_text.substr(0, space);
+        if (!rating.empty()) {
+            ratings.push_back(ParseNumber<int>(rating, "rating"));
+        }
+        ratings_text.remove_prefix(space == string_view::npos ? ratings_text.size() : space + 1);
+    }
+    return search_server.PrepareDocument(document_id, line, status, ratings);
+}
+
+void TokenizeBatch(const SearchServer& search_server, Batch& batch) {
+    string_view text = batch.text;
+    for (size_t line_index = 0; !text.empty(); ++line_index) {
+        const size_t newline = text.find('\n');
+        string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == string_view::npos ? text.size() : newline + 1);
+        batch.line_count = line_index + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            batch.documents.push_back(ParseLine(search_server, line));
+            batch.document_lines.push_back(line_index);
+        }
+        catch (const exception& e) {
+            batch.error.emplace(line_index, e.what());
+            return;
+        }
+    }
+}
+
+class Pipeline {
+public:
+    Pipeline(SearchServer& search_server, ChunkSource& source, const LoaderOptions& options)
+        : search_server_(search_server)
+        , source_(source)
+        , options_(options)
+        , worker_count_(options.worker_count ? options.worker_count
+            : max<size_t>(thread::hardware_concurrency(), 2) - 1)
+        , max_in_flight_(options.max_batches_in_flight ? options.max_batches_in_flight : worker_count_ * 2)
+        , in_flight_(static_cast<ptrdiff_t>(max_in_flight_)) {
+        reader_ = thread([this] {
+            Read();
+            });
+        for (size_t i = 0; i < worker_count_; ++i) {
+            workers_.emplace_back([this] {
+                Tokenize();
+                });
+        }
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    ~Pipeline() {
+        stopping_ = true;
+        in_flight_.release(static_cast<ptrdiff_t>(max_in_flight_));
+        work_queue_.Close();
+        reader_.join();
+        for (thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    LoadStats Insert() {
+        const auto start_time = chrono::steady_clock::now();
+        const auto elapsed = [start_time] {
+            return chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+        };
+        LoadStats stats;
+        size_t line_base = 0;
+        for (size_t sequence = 0;; ++sequence) {
+            const unique_ptr<Batch> batch = reorder_buffer_.Take(sequence);
+            if (!batch) {
+                break;
+            }
+            for (size_t i = 0; i < batch->documents.size(); ++i) {
+                try {
+                    search_server_.AddPreparedDocument(batch->documents[i]);
+                }
+                catch (const invalid_argument& e) {
+                    throw invalid_argument("Line " + to_string(line_base + batch->document_lines[i] + 1) + ": " + e.what());
+                }
+                ++stats.documents;
+                if (options_.on_progress && options_.progress_interval
+                    && stats.documents % options_.progress_interval == 0) {
+                    stats.seconds = elapsed();
+                    options_.on_progress(stats);
+                }
+            }
+            if (batch->error) {
+                throw invalid_argument("Line " + to_string(line_base + batch->error->first + 1) + ": " + batch->error->second);
+            }
+            line_base += batch->line_count;
+            stats.bytes += batch->text.size();
+            in_flight_.release();
+        }
+        if (read_error_) {
+            rethrow_exception(read_error_);
+        }
+        stats.seconds = elapsed();
+        return stats;
+    }
+
+private:
+    SearchServer& search_server_;
+    ChunkSource& source_;
+    const LoaderOptions& options_;
+    const size_t worker_count_;
+    const size_t max_in_flight_;
+    counting_semaphore<> in_flight_;
+    atomic<bool> stopping_ = false;
+    exception_ptr read_error_;
+    BlockingQueue<pair<size_t, unique_ptr<Batch>>> work_queue_;
+    ReorderBuffer reorder_buffer_;
+    thread reader_;
+    vector<thread> workers_;
+
+    void Read() {
+        size_t sequence = 0;
+        try {
+            for (;; ++sequence) {
+                in_flight_.acquire();
+                if (stopping_) {
+                    break;
+                }
+                auto batch = make_unique<Batch>();
+                if (!source_.Next(*batch)) {
+                    break;
+                }
+                work_queue_.Push({ sequence, move(batch) });
+            }
+        }
+        catch (...) {
+            read_error_ = current_exception();
+        }
+        work_queue_.Close();
+        reorder_buffer_.Finish(sequence);
+    }
+
+    void Tokenize() {
+        while (auto item = work_queue_.Pop()) {
+            if (stopping_) {
+                break;
+            }
+            auto& [sequence, batch] = *item;
+            TokenizeBatch(search_server_, *batch);
+            reorder_buffer_.Put(sequence, move(batch));
+        }
+    }
+};
+
+LoadStats Load(SearchServer& search_server, ChunkSource& source, const LoaderOptions& options) {
+    if (options.batch_bytes == 0) {
+        throw invalid_argument("Loader batch size must be positive");
+    }
+    Pipeline pipeline(search_server, source, options);
+    return pipeline.Insert();
+}
+
+}  // namespace
+
+LoadStats LoadDocuments(SearchServer& search_server, istream& input, const LoaderOptions& options) {
+    StreamSource source(input, options.batch_bytes);
+    return Load(search_server, source, options);
+}
+
+LoadStats LoadDocumentsFromFile(SearchServer& search_server, const string& path, const LoaderOptions& options) {
+    MappedFileSource source(path, options.batch_bytes);
+    return Load(search_server, source, options);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "search_server.h"
+
+struct LoadStats {
+    size_t documents = 0;
+    size_t bytes = 0;
+    double seconds = 0;
+
+    double GetDocumentsPerSecond() const;
+    double GetMegabytesPerSecond() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const LoadStats& stats);
+
+struct LoaderOptions {
+    size_t batch_bytes = 4 << 20;
+    // Tokenizer threads; zero picks one per hardware thread besides the inserting one
+    size_t worker_count = 0;
+    // Batches read but not yet indexed; the reader blocks beyond it. Zero means twice the worker count
+    size_t max_batches_in_flight = 0;
+    size_t progress_interval = 100'000;
+    std::function<void(const LoadStats&)> on_progress;
+};
+
+// Each line is "id<TAB>status<TAB>ratings<TAB>text" with a status name or number and space-separated ratings.
+// Documents are indexed in file order; a malformed line stops the load after the lines before it.
+LoadStats LoadDocuments(SearchServer& search_server, std::istream& input, const LoaderOptions& options = {});
+LoadStats LoadDocumentsFromFile(SearchServer& search_server, const std::string& path, const LoaderOptions& options = {});
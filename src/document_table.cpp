@@ -0,0 +1,135 @@
+#include "document_table.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+DocumentTable::DocumentTable(pmr::memory_resource* resource)
+    : id_to_slot_(resource)
+    , ids_(resource)
+    , statuses_(resource)
+    , ratings_(resource)
+    , lengths_(resource)
+    , alive_(resource)
+    , free_slots_(resource)
+    , sorted_ids_(resource) {}
+
+DocumentTable::DocumentTable(DocumentTable&& other)
+    : id_to_slot_(move(other.id_to_slot_))
+    , ids_(move(other.ids_))
+    , statuses_(move(other.statuses_))
+    , ratings_(move(other.ratings_))
+    , lengths_(move(other.lengths_))
+    , alive_(move(other.alive_))
+    , free_slots_(move(other.free_slots_))
+    , sorted_ids_(move(other.sorted_ids_))
+    , is_sorted_(other.is_sorted_) {}
+
+size_t DocumentTable::Add(int document_id, DocumentStatus status, int rating, int length) {
+    size_t slot = ids_.size();
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    else {
+        ids_.emplace_back();
+        statuses_.emplace_back();
+        ratings_.emplace_back();
+        lengths_.emplace_back();
+        alive_.emplace_back();
+    }
+    ids_[slot] = document_id;
+    statuses_[slot] = status;
+    ratings_[slot] = rating;
+    lengths_[slot] = length;
+    alive_[slot] = 1;
+    id_to_slot_.emplace(document_id, slot);
+    if (is_sorted_ && (sorted_ids_.empty() || sorted_ids_.back() < document_id)) {
+        sorted_ids_.push_back(document_id);
+    }
+    else {
+        is_sorted_ = false;
+    }
+    return slot;
+}
+
+void DocumentTable::Remove(size_t slot) {
+    const int document_id = ids_[slot];
+    id_to_slot_.erase(document_id);
+    alive_[slot] = 0;
+    free_slots_.push_back(slot);
+    if (is_sorted_ && sorted_ids_.back() == document_id) {
+        sorted_ids_.pop_back();
+    }
+    else {
+        is_sorted_ = false;
+    }
+}
+
+size_t DocumentTable::Find(int document_id) const {
+    const auto it = id_to_slot_.find(document_id);
+    return it == id_to_slot_.end() ? NO_SLOT : it->second;
+}
+
+size_t DocumentTable::GetSlot(int document_id) const {
+    const size_t slot = Find(document_id);
+    if (slot == NO_SLOT) {
+        throw out_of_range("Document with ID " + to_string(document_id) + " not found");
+    }
+    return slot;
+}
+
+void DocumentTable::SetStatus(size_t slot, DocumentStatus status) {
+    statuses_[slot] = status;
+}
+
+void DocumentTable::SetRating(size_t slot, int rating) {
+    ratings_[slot] = rating;
+}
+
+void DocumentTable::SetLength(size_t slot, int length) {
+    lengths_[slot] = length;
+}
+
+void DocumentTable::ShrinkToFit() {
+    ids_.shrink_to_fit();
+    statuses_.shrink_to_fit();
+    ratings_.shrink_to_fit();
+    lengths_.shrink_to_fit();
+    alive_.shrink_to_fit();
+    free_slots_.shrink_to_fit();
+    sorted_ids_.shrink_to_fit();
+}
+
+size_t DocumentTable::size() const {
+    return id_to_slot_.size();
+}
+
+size_t DocumentTable::GetSlotCount() const {
+    return ids_.size();
+}
+
+pmr::vector<int>::const_iterator DocumentTable::begin() const {
+    return GetSortedIds().begin();
+}
+
+pmr::vector<int>::const_iterator DocumentTable::end() const {
+    return GetSortedIds().end();
+}
+
+const pmr::vector<int>& DocumentTable::GetSortedIds() const {
+    lock_guard guard(sort_mutex_);
+    if (!is_sorted_) {
+        sorted_ids_.clear();
+        for (size_t slot = 0; slot < ids_.size(); ++slot) {
+            if (alive_[slot] != 0) {
+                sorted_ids_.push_back(ids_[slot]);
+            }
+        }
+        sort(sorted_ids_.begin(), sorted_ids_.end());
+        is_sorted_ = true;
+    }
+    return sorted_ids_;
+}
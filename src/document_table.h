@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+// Dense per-document metadata: external ids map to reusable slots, and every field is a
+// slot-indexed array, so per-posting lookups are plain indexing
+class DocumentTable {
+public:
+    static constexpr size_t NO_SLOT = SIZE_MAX;
+
+    explicit DocumentTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    DocumentTable(DocumentTable&& other);
+
+    size_t Add(int document_id, DocumentStatus status, int rating, int length);
+    void Remove(size_t slot);
+
+    size_t Find(int document_id) const;
+    // Throws out_of_range for an unknown id
+    size_t GetSlot(int document_id) const;
+
+    int GetId(size_t slot) const {
+        return ids_[slot];
+    }
+
+    DocumentStatus GetStatus(size_t slot) const {
+        return statuses_[slot];
+    }
+
+    int GetRating(size_t slot) const {
+        return ratings_[slot];
+    }
+
+    int GetLength(size_t slot) const {
+        return lengths_[slot];
+    }
+
+    bool IsAlive(size_t slot) const {
+        return alive_[slot] != 0;
+    }
+
+    void SetStatus(size_t slot, DocumentStatus status);
+    void SetRating(size_t slot, int rating);
+    void SetLength(size_t slot, int length);
+
+    size_t size() const;
+    void ShrinkToFit();
+    // Upper bound for slots, for callers sizing slot-indexed arrays of their own
+    size_t GetSlotCount() const;
+
+    // Ids in ascending order, valid until the next Add or Remove
+    std::pmr::vector<int>::const_iterator begin() const;
+    std::pmr::vector<int>::const_iterator end() const;
+
+private:
+    std::pmr::unordered_map<int, size_t> id_to_slot_;
+    std::pmr::vector<int> ids_;
+    std::pmr::vector<DocumentStatus> statuses_;
+    std::pmr::vector<int> ratings_;
+    std::pmr::vector<int> lengths_;
+    std::pmr::vector<uint8_t> alive_;
+    std::pmr::vector<size_t> free_slots_;
+    // Ascending adds append; anything else marks the order stale, and the next iteration rebuilds it
+    // from the alive slots, so shuffled loads and removals never shift ids one by one
+    mutable std::pmr::vector<int> sorted_ids_;
+    mutable bool is_sorted_ = true;
+    mutable std::mutex sort_mutex_;
+
+    const std::pmr::vector<int>& GetSortedIds() const;
+};
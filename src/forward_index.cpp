@@ -0,0 +1,74 @@
+#include "forward_index.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ForwardIndex::ForwardIndex(pmr::memory_resource* resource)
+    : entries_(resource), spans_(resource) {}
+
+void ForwardIndex::Add(size_t slot, const vector<Entry>& entries) {
+    if (slot >= spans_.size()) {
+        spans_.resize(slot + 1);
+    }
+    spans_[slot] = { entries_.size(), entries.size() };
+    entries_.insert(entries_.end(), entries.begin(), entries.end());
+}
+
+void ForwardIndex::Remove(size_t slot) {
+    garbage_size_ += spans_[slot].size;
+    spans_[slot] = {};
+    if (garbage_size_ * 2 > entries_.size()) {
+        Compact();
+    }
+}
+
+void ForwardIndex::Replace(size_t slot, const vector<Entry>& entries) {
+    Span& span = spans_[slot];
+    if (entries.size() <= span.size) {
+        copy(entries.begin(), entries.end(), entries_.begin() + span.offset);
+        garbage_size_ += span.size - entries.size();
+        span.size = entries.size();
+    }
+    else {
+        garbage_size_ += span.size;
+        span = { entries_.size(), entries.size() };
+        entries_.insert(entries_.end(), entries.begin(), entries.end());
+    }
+    if (garbage_size_ * 2 > entries_.size()) {
+        Compact();
+    }
+}
+
+span<const ForwardIndex::Entry> ForwardIndex::Get(size_t slot) const {
+    const Span& span = spans_[slot];
+    return { entries_.data() + span.offset, span.size };
+}
+
+void ForwardIndex::Compact() {
+    vector<size_t> slots;
+    for (size_t slot = 0; slot < spans_.size(); ++slot) {
+        if (spans_[slot].size > 0) {
+            slots.push_back(slot);
+        }
+    }
+    sort(slots.begin(), slots.end(), [this](size_t lhs, size_t rhs) {
+        return spans_[lhs].offset < spans_[rhs].offset;
+        });
+    // Spans only ever move towards the front, so visiting them in offset order never overwrites live entries
+    size_t size = 0;
+    for (const size_t slot : slots) {
+        Span& span = spans_[slot];
+        const auto first = entries_.begin() + span.offset;
+        copy(first, first + span.size, entries_.begin() + size);
+        span.offset = size;
+        size += span.size;
+    }
+    entries_.resize(size);
+    garbage_size_ = 0;
+}
+
+void ForwardIndex::ShrinkToFit() {
+    entries_.shrink_to_fit();
+    spans_.shrink_to_fit();
+}
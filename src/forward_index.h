@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "term_dictionary.h"
+
+class ForwardIndex {
+public:
+    struct Entry {
+        int term_id;
+        double term_freq;
+    };
+
+    explicit ForwardIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Slots are handed out by the caller and may be reused after Remove
+    void Add(size_t slot, const std::vector<Entry>& entries);
+    void Remove(size_t slot);
+    void Replace(size_t slot, const std::vector<Entry>& entries);
+    std::span<const Entry> Get(size_t slot) const;
+    // Drops entries left behind by Remove and Replace without allocating; the capacity stays
+    void Compact();
+    // Reallocates down to the live entries, so briefly holds both copies
+    void ShrinkToFit();
+
+private:
+    struct Span {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    std::pmr::vector<Entry> entries_;
+    std::pmr::vector<Span> spans_;
+    size_t garbage_size_ = 0;
+};
+
+// A view into the forward index: any later Add, Remove or UpdateDocument on the server may
+// compact or reallocate the entries and leaves the view dangling
+class WordFrequencies {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+        Iterator(const ForwardIndex::Entry* entry, const TermDictionary* dictionary)
+            : entry_(entry), dictionary_(dictionary) {}
+
+        value_type operator*() const {
+            return { dictionary_->GetWord(entry_->term_id), entry_->term_freq };
+        }
+
+        Iterator& operator++() {
+            ++entry_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++entry_;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return entry_ == other.entry_;
+        }
+
+    private:
+        const ForwardIndex::Entry* entry_ = nullptr;
+        const TermDictionary* dictionary_ = nullptr;
+    };
+
+    WordFrequencies() = default;
+    WordFrequencies(std::span<const ForwardIndex::Entry> entries, const TermDictionary& dictionary)
+        : entries_(entries), dictionary_(&dictionary) {}
+
+    Iterator begin() const {
+        return { entries_.data(), dictionary_ };
+    }
+
+    Iterator end() const {
+        return { entries_.data() + entries_.size(), dictionary_ };
+    }
+
+    size_t size() const {
+        return entries_.size();
+    }
+
+    bool empty() const {
+        return entries_.empty();
+    }
+
+    std::span<const ForwardIndex::Entry> GetEntries() const {
+        return entries_;
+    }
+
+private:
+    std::span<const ForwardIndex::Entry> entries_;
+    const TermDictionary* dictionary_ = nullptr;
+};
@@ -0,0 +1,60 @@
+#include "local_executor.h"
+
+#include <algorithm>
+
+using namespace std;
+
+LocalExecutor::LocalExecutor(size_t thread_count) {
+    thread_count = max<size_t>(thread_count, 1);
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this] {
+            Run();
+            });
+    }
+}
+
+LocalExecutor::~LocalExecutor() {
+    {
+        lock_guard g(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (thread& worker : threads_) {
+        worker.join();
+    }
+}
+
+LocalExecutor::ScheduleAwaiter LocalExecutor::Schedule() {
+    return ScheduleAwaiter(*this);
+}
+
+size_t LocalExecutor::GetThreadCount() const {
+    return threads_.size();
+}
+
+void LocalExecutor::Post(coroutine_handle<> handle) {
+    {
+        lock_guard g(mutex_);
+        ready_.push_back(handle);
+    }
+    condition_.notify_one();
+}
+
+void LocalExecutor::Run() {
+    while (true) {
+        coroutine_handle<> handle;
+        {
+            unique_lock lock(mutex_);
+            condition_.wait(lock, [this] {
+                return stopping_ || !ready_.empty();
+            });
+            if (ready_.empty()) {
+                return;
+            }
+            handle = ready_.front();
+            ready_.pop_front();
+        }
+        handle.resume();
+    }
+}
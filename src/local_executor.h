@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of threads resuming coroutines that co_await Schedule()
+class LocalExecutor {
+public:
+    class ScheduleAwaiter {
+    public:
+        explicit ScheduleAwaiter(LocalExecutor& executor)
+            : executor_(executor) {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            executor_.Post(handle);
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        LocalExecutor& executor_;
+    };
+
+    explicit LocalExecutor(size_t thread_count = std::thread::hardware_concurrency());
+    LocalExecutor(const LocalExecutor&) = delete;
+    LocalExecutor& operator=(const LocalExecutor&) = delete;
+    // Resumes everything already scheduled before joining the threads
+    ~LocalExecutor();
+
+    ScheduleAwaiter Schedule();
+    size_t GetThreadCount() const;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::coroutine_handle<>> ready_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    void Post(std::coroutine_handle<> handle);
+    void Run();
+};
@@ -10,6 +10,19 @@ vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const
         });
     return final_documents;
 }
+
+vector<SearchResult> ProcessQueries(const SearchServer& search_server, const vector<string>& queries,
+    chrono::steady_clock::duration query_timeout) {
+    vector<SearchResult> results(queries.size());
+    transform(execution::par, queries.begin(), queries.end(), results.begin(),
+        [&search_server, query_timeout](const string& query) {
+            return search_server.FindTopDocuments(execution::seq, query,
+                [](int document_id, DocumentStatus document_status, int rating) {
+                    return document_status == DocumentStatus::ACTUAL;
+                }, QueryLimits{ chrono::steady_clock::now() + query_timeout, stop_token{} });
+        });
+    return results;
+}
 vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries) {
     vector<Document> result;
     for (const vector<Document>& query_document : ProcessQueries(search_server, queries)) {
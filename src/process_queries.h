@@ -1,8 +1,12 @@
 #pragma once
 #include "search_server.h"
+#include <chrono>
 #include <execution>
 
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
+// Each query gets its own deadline, counted from the moment it starts
+std::vector<SearchResult> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries,
+    std::chrono::steady_clock::duration query_timeout);
 
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
 
@@ -0,0 +1,449 @@
+#include "process_shard.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+enum class Command : uint8_t {
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+    UPDATE_DOCUMENT,
+    SET_STATUS,
+    SET_RATING,
+    GET_DOCUMENT_COUNT,
+    COLLECT_TERM_STATISTICS,
+    FIND_TOP_DOCUMENTS,
+    MATCH_DOCUMENT,
+    STOP,
+};
+
+enum class Reply : uint8_t {
+    OK,
+    INVALID_ARGUMENT,
+    OUT_OF_RANGE,
+    ERROR,
+};
+
+class MessageWriter {
+public:
+    template <typename T>
+    void Write(T value) {
+        static_assert(is_trivially_copyable_v<T>);
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void WriteString(string_view text) {
+        Write(static_cast<uint32_t>(text.size()));
+        buffer_.append(text);
+    }
+
+    const string& GetBuffer() const {
+        return buffer_;
+    }
+
+private:
+    string buffer_;
+};
+
+class MessageReader {
+public:
+    explicit MessageReader(string buffer)
+        : buffer_(move(buffer)) {}
+
+    template <typename T>
+    T Read() {
+        static_assert(is_trivially_copyable_v<T>);
+        T value;
+        memcpy(&value, Take(sizeof(value)).data(), sizeof(value));
+        return value;
+    }
+
+    string_view ReadString() {
+        return Take(Read<uint32_t>());
+    }
+
+private:
+    string buffer_;
+    size_t position_ = 0;
+
+    string_view Take(size_t size) {
+        if (buffer_.size() - position_ < size) {
+            throw runtime_error("Truncated shard message");
+        }
+        const string_view result = string_view(buffer_).substr(position_, size);
+        position_ += size;
+        return result;
+    }
+};
+
+void WriteAll(int socket_fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = send(socket_fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error("Shard connection write failed: "s + strerror(errno));
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void ReadAll(int socket_fd, char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t received = recv(socket_fd, data, size, 0);
+        if (received == 0) {
+            throw runtime_error("Shard connection closed");
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error("Shard connection read failed: "s + strerror(errno));
+        }
+        data += received;
+        size -= received;
+    }
+}
+
+void SendMessage(int socket_fd, const string& payload) {
+    const uint32_t size = static_cast<uint32_t>(payload.size());
+    WriteAll(socket_fd, reinterpret_cast<const char*>(&size), sizeof(size));
+    WriteAll(socket_fd, payload.data(), payload.size());
+}
+
+string ReceiveMessage(int socket_fd) {
+    uint32_t size = 0;
+    ReadAll(socket_fd, reinterpret_cast<char*>(&size), sizeof(size));
+    string payload(size, '\0');
+    ReadAll(socket_fd, payload.data(), size);
+    return payload;
+}
+
+void WriteStatistics(MessageWriter& writer, const TermStatistics& statistics) {
+    writer.Write(statistics.document_count);
+    writer.Write(static_cast<uint32_t>(statistics.document_freqs.size()));
+    for (const auto& [word, document_freq] : statistics.document_freqs) {
+        writer.WriteString(word);
+        writer.Write(document_freq);
+    }
+}
+
+TermStatistics ReadStatistics(MessageReader& reader) {
+    TermStatistics statistics;
+    statistics.document_count = reader.Read<int>();
+    const auto size = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < size; ++i) {
+        const string_view word = reader.ReadString();
+        statistics.document_freqs.emplace(word, reader.Read<int>());
+    }
+    return statistics;
+}
+
+void HandleCommand(Command command, MessageReader& request, MessageWriter& reply, SearchServer& search_server) {
+    switch (command) {
+    case Command::ADD_DOCUMENT: {
+        const int document_id = request.Read<int>();
+        const string_view document = request.ReadString();
+        const auto status = request.Read<DocumentStatus>();
+        vector<int> ratings(request.Read<uint32_t>());
+        for (int& rating : ratings) {
+            rating = request.Read<int>();
+        }
+        search_server.AddDocument(document_id, document, status, ratings);
+        return;
+    }
+    case Command::REMOVE_DOCUMENT:
+        search_server.RemoveDocument(request.Read<int>());
+        return;
+    case Command::UPDATE_DOCUMENT: {
+        const int document_id = request.Read<int>();
+        const string_view document = request.ReadString();
+        const auto status = request.Read<DocumentStatus>();
+        vector<int> ratings(request.Read<uint32_t>());
+        for (int& rating : ratings) {
+            rating = request.Read<int>();
+        }
+        search_server.UpdateDocument(document_id, document, status, ratings);
+        return;
+    }
+    case Command::SET_STATUS: {
+        const int document_id = request.Read<int>();
+        search_server.SetStatus(document_id, request.Read<DocumentStatus>());
+        return;
+    }
+    case Command::SET_RATING: {
+        const int document_id = request.Read<int>();
+        search_server.SetRating(document_id, request.Read<int>());
+        return;
+    }
+    case Command::GET_DOCUMENT_COUNT:
+        reply.Write(search_server.GetDocumentCount());
+        return;
+    case Command::COLLECT_TERM_STATISTICS:
+        WriteStatistics(reply, search_server.CollectTermStatistics(request.ReadString()));
+        return;
+    case Command::FIND_TOP_DOCUMENTS: {
+        const string_view raw_query = request.ReadString();
+        const auto status = request.Read<DocumentStatus>();
+        const TermStatistics statistics = ReadStatistics(request);
+        const auto documents = search_server.FindTopDocuments(execution::seq, raw_query,
+            [status](int document_id, DocumentStatus document_status, int rating) {
+                return document_status == status;
+            }, statistics);
+        reply.Write(static_cast<uint32_t>(documents.size()));
+        for (const Document& document : documents) {
+            reply.Write(document.id);
+            reply.Write(document.relevance);
+            reply.Write(document.rating);
+        }
+        return;
+    }
+    case Command::MATCH_DOCUMENT: {
+        const string_view raw_query = request.ReadString();
+        const auto [words, status] = search_server.MatchDocument(raw_query, request.Read<int>());
+        reply.Write(status);
+        reply.Write(static_cast<uint32_t>(words.size()));
+        for (const string_view word : words) {
+            reply.WriteString(word);
+        }
+        return;
+    }
+    case Command::STOP:
+        return;
+    }
+    throw runtime_error("Unknown shard command " + to_string(static_cast<int>(command)));
+}
+
+}  // namespace
+
+void ServeShard(int socket_fd, SearchServer& search_server) {
+    while (true) {
+        string request;
+        try {
+            request = ReceiveMessage(socket_fd);
+        }
+        catch (const runtime_error&) {
+            return;
+        }
+        MessageReader reader(move(request));
+        MessageWriter reply;
+        try {
+            const auto command = reader.Read<Command>();
+            if (command == Command::STOP) {
+                return;
+            }
+            MessageWriter result;
+            HandleCommand(command, reader, result, search_server);
+            reply.Write(Reply::OK);
+            reply.WriteString(result.GetBuffer());
+        }
+        catch (const invalid_argument& e) {
+            reply.Write(Reply::INVALID_ARGUMENT);
+            reply.WriteString(e.what());
+        }
+        catch (const out_of_range& e) {
+            reply.Write(Reply::OUT_OF_RANGE);
+            reply.WriteString(e.what());
+        }
+        catch (const exception& e) {
+            reply.Write(Reply::ERROR);
+            reply.WriteString(e.what());
+        }
+        SendMessage(socket_fd, reply.GetBuffer());
+    }
+}
+
+unique_ptr<ProcessShard> ProcessShard::Spawn(const string& stop_words_text) {
+    int socket_fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socket_fds) != 0) {
+        throw runtime_error("Cannot create shard socket pair: "s + strerror(errno));
+    }
+    const pid_t child_pid = fork();
+    if (child_pid < 0) {
+        close(socket_fds[0]);
+        close(socket_fds[1]);
+        throw runtime_error("Cannot fork shard process: "s + strerror(errno));
+    }
+    if (child_pid == 0) {
+        // Without exec SOCK_CLOEXEC closes nothing, and a child holding the sockets of earlier shards would keep
+        // them open after their owners close them
+        const unsigned own_fd = static_cast<unsigned>(socket_fds[1]);
+        if (own_fd > STDERR_FILENO + 1) {
+            close_range(STDERR_FILENO + 1, own_fd - 1, 0);
+        }
+        close_range(own_fd + 1, ~0U, 0);
+        int exit_code = 0;
+        try {
+            SearchServer search_server(stop_words_text);
+            ServeShard(socket_fds[1], search_server);
+        }
+        catch (...) {
+            exit_code = 1;
+        }
+        close(socket_fds[1]);
+        _exit(exit_code);
+    }
+    close(socket_fds[1]);
+    return make_unique<ProcessShard>(socket_fds[0], child_pid);
+}
+
+ProcessShard::ProcessShard(int socket_fd, int child_pid)
+    : socket_fd_(socket_fd), child_pid_(child_pid) {}
+
+ProcessShard::~ProcessShard() {
+    // A broken stream may hold half a message, so the child is stopped by the closed socket alone
+    if (!is_broken_) {
+        try {
+            MessageWriter request;
+            request.Write(Command::STOP);
+            SendMessage(socket_fd_, request.GetBuffer());
+        }
+        catch (const exception&) {
+        }
+    }
+    close(socket_fd_);
+    if (child_pid_ > 0) {
+        waitpid(child_pid_, nullptr, 0);
+    }
+}
+
+string ProcessShard::Call(const string& request) const {
+    MessageReader reply = [&] {
+        lock_guard g(mutex_);
+        if (is_broken_) {
+            throw runtime_error("Shard connection is broken");
+        }
+        try {
+            SendMessage(socket_fd_, request);
+            return MessageReader(ReceiveMessage(socket_fd_));
+        }
+        catch (const runtime_error&) {
+            is_broken_ = true;
+            throw;
+        }
+    }();
+    const auto status = reply.Read<Reply>();
+    const string payload(reply.ReadString());
+    switch (status) {
+    case Reply::OK:
+        return payload;
+    case Reply::INVALID_ARGUMENT:
+        throw invalid_argument(payload);
+    case Reply::OUT_OF_RANGE:
+        throw out_of_range(payload);
+    default:
+        throw runtime_error(payload);
+    }
+}
+
+void ProcessShard::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    MessageWriter request;
+    request.Write(Command::ADD_DOCUMENT);
+    request.Write(document_id);
+    request.WriteString(document);
+    request.Write(status);
+    request.Write(static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        request.Write(rating);
+    }
+    Call(request.GetBuffer());
+}
+
+void ProcessShard::RemoveDocument(int document_id) {
+    MessageWriter request;
+    request.Write(Command::REMOVE_DOCUMENT);
+    request.Write(document_id);
+    Call(request.GetBuffer());
+}
+
+void ProcessShard::UpdateDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    MessageWriter request;
+    request.Write(Command::UPDATE_DOCUMENT);
+    request.Write(document_id);
+    request.WriteString(document);
+    request.Write(status);
+    request.Write(static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        request.Write(rating);
+    }
+    Call(request.GetBuffer());
+}
+
+void ProcessShard::SetStatus(int document_id, DocumentStatus status) {
+    MessageWriter request;
+    request.Write(Command::SET_STATUS);
+    request.Write(document_id);
+    request.Write(status);
+    Call(request.GetBuffer());
+}
+
+void ProcessShard::SetRating(int document_id, int rating) {
+    MessageWriter request;
+    request.Write(Command::SET_RATING);
+    request.Write(document_id);
+    request.Write(rating);
+    Call(request.GetBuffer());
+}
+
+int ProcessShard::GetDocumentCount() const {
+    MessageWriter request;
+    request.Write(Command::GET_DOCUMENT_COUNT);
+    MessageReader reply(Call(request.GetBuffer()));
+    return reply.Read<int>();
+}
+
+TermStatistics ProcessShard::CollectTermStatistics(string_view raw_query) const {
+    MessageWriter request;
+    request.Write(Command::COLLECT_TERM_STATISTICS);
+    request.WriteString(raw_query);
+    MessageReader reply(Call(request.GetBuffer()));
+    return ReadStatistics(reply);
+}
+
+vector<Document> ProcessShard::FindTopDocuments(string_view raw_query, DocumentStatus status,
+    const TermStatistics& statistics) const {
+    MessageWriter request;
+    request.Write(Command::FIND_TOP_DOCUMENTS);
+    request.WriteString(raw_query);
+    request.Write(status);
+    WriteStatistics(request, statistics);
+    MessageReader reply(Call(request.GetBuffer()));
+    vector<Document> documents(reply.Read<uint32_t>());
+    for (Document& document : documents) {
+        document.id = reply.Read<int>();
+        document.relevance = reply.Read<double>();
+        document.rating = reply.Read<int>();
+    }
+    return documents;
+}
+
+vector<Document> ProcessShard::FindTopDocuments(string_view, const DocumentFilter&, const TermStatistics&) const {
+    throw logic_error("Document predicates cannot be sent to a process shard, filter by status instead");
+}
+
+tuple<vector<string>, DocumentStatus> ProcessShard::MatchDocument(string_view raw_query, int document_id) const {
+    MessageWriter request;
+    request.Write(Command::MATCH_DOCUMENT);
+    request.WriteString(raw_query);
+    request.Write(document_id);
+    MessageReader reply(Call(request.GetBuffer()));
+    const auto status = reply.Read<DocumentStatus>();
+    vector<string> words(reply.Read<uint32_t>());
+    for (string& word : words) {
+        word = reply.ReadString();
+    }
+    return { move(words), status };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "search_shard.h"
+
+// Serves search_server over a connected stream socket until the peer stops it or disconnects
+void ServeShard(int socket_fd, SearchServer& search_server);
+
+class ProcessShard : public SearchShard {
+public:
+    // Forks a child process serving an empty SearchServer; spawn shards before starting parallel work
+    static std::unique_ptr<ProcessShard> Spawn(const std::string& stop_words_text);
+
+    explicit ProcessShard(int socket_fd, int child_pid = -1);
+    ProcessShard(const ProcessShard&) = delete;
+    ProcessShard& operator=(const ProcessShard&) = delete;
+    ~ProcessShard() override;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) override;
+    void RemoveDocument(int document_id) override;
+    void UpdateDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) override;
+    void SetStatus(int document_id, DocumentStatus status) override;
+    void SetRating(int document_id, int rating) override;
+    int GetDocumentCount() const override;
+
+    TermStatistics CollectTermStatistics(std::string_view raw_query) const override;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        const TermStatistics& statistics) const override;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& document_filter,
+        const TermStatistics& statistics) const override;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query,
+        int document_id) const override;
+
+private:
+    int socket_fd_;
+    int child_pid_;
+    mutable std::mutex mutex_;
+    // Set after any I/O failure: the stream may be out of step, so later calls fail instead of misreading replies
+    mutable bool is_broken_ = false;
+
+    std::string Call(const std::string& request) const;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <stop_token>
+#include <vector>
+
+#include "document.h"
+
+// Queries poll their limits after every block of this many postings
+const size_t POSTING_BLOCK_SIZE = 1024;
+
+struct QueryLimits {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::stop_token stop_token;
+};
+
+struct SearchResult {
+    std::vector<Document> documents;
+    // False when the deadline or a stop request cut the posting scan short; documents are then a best-effort top-K
+    bool is_complete = true;
+};
+
+class QueryBudget {
+public:
+    explicit QueryBudget(const QueryLimits& limits)
+        : limits_(limits) {}
+
+    bool IsExhausted() const {
+        if (exhausted_.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (limits_.stop_token.stop_requested() || std::chrono::steady_clock::now() >= limits_.deadline) {
+            exhausted_.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    bool WasExhausted() const {
+        return exhausted_.load(std::memory_order_relaxed);
+    }
+
+private:
+    const QueryLimits& limits_;
+    mutable std::atomic<bool> exhausted_ = false;
+};
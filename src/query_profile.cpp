@@ -0,0 +1,257 @@
+#include "query_profile.h"
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+const char* GetQueryStageName(QueryStage stage) {
+    switch (stage) {
+    case QueryStage::PARSE:
+        return "parse";
+    case QueryStage::POSTING_SCAN:
+        return "posting_scan";
+    case QueryStage::MINUS_FILTER:
+        return "minus_filter";
+    case QueryStage::TOP_K:
+        return "top_k";
+    case QueryStage::RESULT_BUILD:
+        return "result_build";
+    }
+    return "unknown";
+}
+
+const char* GetQueryCounterName(QueryCounter counter) {
+    switch (counter) {
+    case QueryCounter::POSTINGS_SCANNED:
+        return "postings_scanned";
+    case QueryCounter::DOCUMENTS_SCORED:
+        return "documents_scored";
+    }
+    return "unknown";
+}
+
+void Histogram::Add(uint64_t value) {
+    ++buckets_[GetBucket(value)];
+    ++count_;
+    sum_ += value;
+    max_ = max(max_, value);
+}
+
+void Histogram::Merge(const Histogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = max(max_, other.max_);
+}
+
+uint64_t Histogram::GetCount() const {
+    return count_;
+}
+
+uint64_t Histogram::GetSum() const {
+    return sum_;
+}
+
+uint64_t Histogram::GetMax() const {
+    return max_;
+}
+
+double Histogram::GetMean() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_;
+}
+
+uint64_t Histogram::GetPercentile(double quantile) const {
+    const uint64_t rank = static_cast<uint64_t>(quantile * count_);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += buckets_[bucket];
+        if (seen > rank) {
+            return min(GetBucketUpperBound(bucket), max_);
+        }
+    }
+    return max_;
+}
+
+const array<uint64_t, Histogram::BUCKET_COUNT>& Histogram::GetBuckets() const {
+    return buckets_;
+}
+
+// Four linear sub-buckets per power of two keep percentiles within 25% of the true value
+size_t Histogram::GetBucket(uint64_t value) {
+    if (value < 4) {
+        return value;
+    }
+    const int exponent = bit_width(value) - 1;
+    const uint64_t sub_bucket = (value >> (exponent - 2)) & 3;
+    return 4 + (exponent - 2) * 4 + sub_bucket;
+}
+
+uint64_t Histogram::GetBucketUpperBound(size_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    const int shift = static_cast<int>((bucket - 4) / 4);
+    const uint64_t lower = (4 + (bucket - 4) % 4) << shift;
+    return lower + ((uint64_t{ 1 } << shift) - 1);
+}
+
+uint64_t QueryProfileSnapshot::GetQueryCount() const {
+    return stage_ns[static_cast<size_t>(QueryStage::PARSE)].GetCount();
+}
+
+void QueryProfileSnapshot::PrintText(ostream& out) const {
+    const auto print_row = [&out](const char* name, const Histogram& histogram) {
+        out << left << setw(18) << name << right << fixed << setprecision(1)
+            << setw(14) << histogram.GetMean()
+            << setw(12) << histogram.GetPercentile(0.5)
+            << setw(12) << histogram.GetPercentile(0.9)
+            << setw(12) << histogram.GetPercentile(0.99)
+            << setw(12) << histogram.GetMax() << endl;
+    };
+    out << "queries: " << GetQueryCount() << endl;
+    out << left << setw(18) << "stage, ns" << right << setw(14) << "mean" << setw(12) << "p50"
+        << setw(12) << "p90" << setw(12) << "p99" << setw(12) << "max" << endl;
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        print_row(GetQueryStageName(static_cast<QueryStage>(i)), stage_ns[i]);
+    }
+    out << left << setw(18) << "per query" << right << setw(14) << "mean" << setw(12) << "p50"
+        << setw(12) << "p90" << setw(12) << "p99" << setw(12) << "max" << endl;
+    for (size_t i = 0; i < QUERY_COUNTER_COUNT; ++i) {
+        print_row(GetQueryCounterName(static_cast<QueryCounter>(i)), counters[i]);
+    }
+}
+
+void QueryProfileSnapshot::PrintJson(ostream& out) const {
+    const auto print_histogram = [&out](const char* name, const Histogram& histogram) {
+        out << "    \"" << name << "\": { "
+            << "\"count\": " << histogram.GetCount()
+            << ", \"sum\": " << histogram.GetSum()
+            << ", \"mean\": " << histogram.GetMean()
+            << ", \"p50\": " << histogram.GetPercentile(0.5)
+            << ", \"p90\": " << histogram.GetPercentile(0.9)
+            << ", \"p99\": " << histogram.GetPercentile(0.99)
+            << ", \"max\": " << histogram.GetMax()
+            << ", \"buckets\": [";
+        bool first = true;
+        const auto& buckets = histogram.GetBuckets();
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            if (buckets[i] != 0) {
+                out << (first ? "" : ", ") << "[" << Histogram::GetBucketUpperBound(i) << ", " << buckets[i] << "]";
+                first = false;
+            }
+        }
+        out << "] }";
+    };
+    out << "{\n  \"queries\": " << GetQueryCount() << ",\n  \"stage_ns\": {\n";
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        print_histogram(GetQueryStageName(static_cast<QueryStage>(i)), stage_ns[i]);
+        out << (i + 1 < QUERY_STAGE_COUNT ? ",\n" : "\n");
+    }
+    out << "  },\n  \"per_query\": {\n";
+    for (size_t i = 0; i < QUERY_COUNTER_COUNT; ++i) {
+        print_histogram(GetQueryCounterName(static_cast<QueryCounter>(i)), counters[i]);
+        out << (i + 1 < QUERY_COUNTER_COUNT ? ",\n" : "\n");
+    }
+    out << "  }\n}" << endl;
+}
+
+namespace {
+
+void Merge(QueryProfileSnapshot& to, const QueryProfileSnapshot& from) {
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        to.stage_ns[i].Merge(from.stage_ns[i]);
+    }
+    for (size_t i = 0; i < QUERY_COUNTER_COUNT; ++i) {
+        to.counters[i].Merge(from.counters[i]);
+    }
+}
+
+struct ThreadProfile {
+    mutex guard;
+    QueryProfileSnapshot data;
+};
+
+struct Registry {
+    mutex guard;
+    set<ThreadProfile*> threads;
+    QueryProfileSnapshot finished_threads;
+};
+
+Registry& GetRegistry() {
+    // Never destroyed: thread_local holders may outlive function-local statics
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+class ThreadProfileHolder {
+public:
+    ThreadProfileHolder() {
+        Registry& registry = GetRegistry();
+        lock_guard g(registry.guard);
+        registry.threads.insert(&profile_);
+    }
+
+    ~ThreadProfileHolder() {
+        Registry& registry = GetRegistry();
+        lock_guard g(registry.guard);
+        lock_guard profile_guard(profile_.guard);
+        Merge(registry.finished_threads, profile_.data);
+        registry.threads.erase(&profile_);
+    }
+
+    ThreadProfile& Get() {
+        return profile_;
+    }
+
+private:
+    ThreadProfile profile_;
+};
+
+[[maybe_unused]] ThreadProfile& GetThreadProfile() {
+    thread_local ThreadProfileHolder holder;
+    return holder.Get();
+}
+
+}  // namespace
+
+QueryProfileSnapshot TakeQueryProfileSnapshot() {
+    Registry& registry = GetRegistry();
+    lock_guard g(registry.guard);
+    QueryProfileSnapshot snapshot = registry.finished_threads;
+    for (ThreadProfile* profile : registry.threads) {
+        lock_guard profile_guard(profile->guard);
+        Merge(snapshot, profile->data);
+    }
+    return snapshot;
+}
+
+void ResetQueryProfile() {
+    Registry& registry = GetRegistry();
+    lock_guard g(registry.guard);
+    registry.finished_threads = {};
+    for (ThreadProfile* profile : registry.threads) {
+        lock_guard profile_guard(profile->guard);
+        profile->data = {};
+    }
+}
+
+#ifdef SEARCH_SERVER_PROFILING
+
+QueryProfiler::~QueryProfiler() {
+    ThreadProfile& profile = GetThreadProfile();
+    lock_guard g(profile.guard);
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        profile.data.stage_ns[i].Add(stage_ns_[i].load(memory_order_relaxed));
+    }
+    for (size_t i = 0; i < QUERY_COUNTER_COUNT; ++i) {
+        profile.data.counters[i].Add(counters_[i].load(memory_order_relaxed));
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+enum class QueryStage {
+    PARSE,
+    // The fused loop that scans postings and accumulates relevance, timed as production runs it
+    POSTING_SCAN,
+    MINUS_FILTER,
+    TOP_K,
+    RESULT_BUILD,
+};
+
+enum class QueryCounter {
+    POSTINGS_SCANNED,
+    DOCUMENTS_SCORED,
+};
+
+constexpr size_t QUERY_STAGE_COUNT = 5;
+constexpr size_t QUERY_COUNTER_COUNT = 2;
+
+const char* GetQueryStageName(QueryStage stage);
+const char* GetQueryCounterName(QueryCounter counter);
+
+class Histogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 252;
+
+    void Add(uint64_t value);
+    void Merge(const Histogram& other);
+
+    uint64_t GetCount() const;
+    uint64_t GetSum() const;
+    uint64_t GetMax() const;
+    double GetMean() const;
+    uint64_t GetPercentile(double quantile) const;
+    const std::array<uint64_t, BUCKET_COUNT>& GetBuckets() const;
+
+    static size_t GetBucket(uint64_t value);
+    static uint64_t GetBucketUpperBound(size_t bucket);
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+struct QueryProfileSnapshot {
+    std::array<Histogram, QUERY_STAGE_COUNT> stage_ns;
+    std::array<Histogram, QUERY_COUNTER_COUNT> counters;
+
+    uint64_t GetQueryCount() const;
+    void PrintText(std::ostream& out) const;
+    void PrintJson(std::ostream& out) const;
+};
+
+QueryProfileSnapshot TakeQueryProfileSnapshot();
+void ResetQueryProfile();
+
+#ifdef SEARCH_SERVER_PROFILING
+
+constexpr bool QUERY_PROFILING_ENABLED = true;
+
+class QueryProfiler {
+public:
+    QueryProfiler() = default;
+    QueryProfiler(const QueryProfiler&) = delete;
+    QueryProfiler& operator=(const QueryProfiler&) = delete;
+    ~QueryProfiler();
+
+    void AddStageTime(QueryStage stage, uint64_t ns) {
+        stage_ns_[static_cast<size_t>(stage)].fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void AddCounter(QueryCounter counter, uint64_t value) {
+        counters_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, QUERY_STAGE_COUNT> stage_ns_{};
+    std::array<std::atomic<uint64_t>, QUERY_COUNTER_COUNT> counters_{};
+};
+
+class QueryStageTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    QueryStageTimer(QueryProfiler& profiler, QueryStage stage)
+        : profiler_(profiler), stage_(stage) {}
+
+    ~QueryStageTimer() {
+        const auto duration = Clock::now() - start_time_;
+        profiler_.AddStageTime(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+private:
+    QueryProfiler& profiler_;
+    const QueryStage stage_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+#else
+
+constexpr bool QUERY_PROFILING_ENABLED = false;
+
+class QueryProfiler {
+public:
+    void AddStageTime(QueryStage, uint64_t) {}
+    void AddCounter(QueryCounter, uint64_t) {}
+};
+
+class QueryStageTimer {
+public:
+    QueryStageTimer(QueryProfiler&, QueryStage) {}
+};
+
+#endif
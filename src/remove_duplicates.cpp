@@ -10,7 +10,7 @@ void RemoveDuplicates(SearchServer& search_server) {
     for (const int document_id : search_server) {
 
         set<string_view> current_document_;
-        for (auto& [word, freqs] : search_server.GetWordFrequencies(document_id)) {
+        for (const auto& [word, freq] : search_server.GetWordFrequencies(document_id)) {
             current_document_.insert(word);
         }
         if (unique_documents.count(current_document_)) {
@@ -3,26 +3,126 @@
 
 using namespace std;
 
-SearchServer::SearchServer(const string& stop_words_text)
-    : SearchServer(SplitIntoWordsView(stop_words_text)) {}
+SearchServer::SearchServer(const string& stop_words_text, const SearchServerResources& resources)
+    : SearchServer(SplitIntoWordsView(stop_words_text), resources) {}
+
+SearchServer::SearchServer(const SearchServerResources& resources)
+    : own_index_resource_(resources.index ? nullptr : make_shared<OwnIndexResource>())
+    , index_resource_(resources.index ? resources.index : &own_index_resource_->pool)
+    , query_resource_(resources.query)
+    , memory_(make_shared<IndexMemory>(index_resource_))
+    , stop_words_(&memory_->dictionary)
+    , dictionary_(&memory_->dictionary)
+    , word_to_slot_freqs_(&memory_->postings)
+    , documents_(&memory_->documents)
+    , forward_index_(&memory_->forward_index) {}
+
+SearchServer::SearchServer(SearchServer&& other)
+    : own_index_resource_(other.own_index_resource_)
+    , index_resource_(other.index_resource_)
+    , query_resource_(other.query_resource_)
+    , memory_(other.memory_)
+    , memory_budget_(other.memory_budget_)
+    , bytes_after_compaction_(other.bytes_after_compaction_)
+    , stop_words_(move(other.stop_words_))
+    , dictionary_(move(other.dictionary_))
+    , word_to_slot_freqs_(move(other.word_to_slot_freqs_))
+    , documents_(move(other.documents_))
+    , forward_index_(move(other.forward_index_)) {}
 
 void SearchServer::AddDocument(int document_id, const string_view& document,
     DocumentStatus status, const vector<int>& ratings) {
+    CheckNewDocumentId(document_id);
+    AddPreparedDocument(PrepareDocument(document_id, document, status, ratings));
+}
+
+SearchServer::PreparedDocument SearchServer::PrepareDocument(int document_id, const string_view& document,
+    DocumentStatus status, const vector<int>& ratings) const {
+    vector<string_view> words = SplitIntoWordsNoStop(document);
+    PreparedDocument result{ document_id, status, ComputeAverageRating(ratings), static_cast<int>(words.size()), {} };
+    const double inv_word_count = 1.0 / words.size();
+    sort(words.begin(), words.end());
+    for (const string_view word : words) {
+        if (!result.word_freqs.empty() && result.word_freqs.back().first == word) {
+            result.word_freqs.back().second += inv_word_count;
+        }
+        else {
+            result.word_freqs.emplace_back(word, inv_word_count);
+        }
+    }
+    return result;
+}
+
+void SearchServer::AddPreparedDocument(const PreparedDocument& document) {
+    CheckNewDocumentId(document.id);
+    CheckMemoryBudget();
+    const vector<ForwardIndex::Entry> entries = InternWords(document);
+    const size_t slot = documents_.Add(document.id, document.status, document.rating, document.length);
+    for (const auto& [term_id, term_freq] : entries) {
+        word_to_slot_freqs_[dictionary_.GetWord(term_id)][slot] = term_freq;
+    }
+    forward_index_.Add(slot, entries);
+}
+
+void SearchServer::UpdateDocument(int document_id, const string_view& document,
+    DocumentStatus status, const vector<int>& ratings) {
+    const size_t slot = documents_.GetSlot(document_id);
+    CheckMemoryBudget();
+    const PreparedDocument prepared = PrepareDocument(document_id, document, status, ratings);
+    const vector<ForwardIndex::Entry> new_entries = InternWords(prepared);
+    const auto old_entries = forward_index_.Get(slot);
+    auto old_it = old_entries.begin();
+    auto new_it = new_entries.begin();
+    while (old_it != old_entries.end() || new_it != new_entries.end()) {
+        if (new_it == new_entries.end() || (old_it != old_entries.end() && old_it->term_id < new_it->term_id)) {
+            word_to_slot_freqs_.at(dictionary_.GetWord(old_it->term_id)).erase(slot);
+            ++old_it;
+        }
+        else if (old_it == old_entries.end() || new_it->term_id < old_it->term_id) {
+            word_to_slot_freqs_[dictionary_.GetWord(new_it->term_id)][slot] = new_it->term_freq;
+            ++new_it;
+        }
+        else {
+            if (old_it->term_freq != new_it->term_freq) {
+                word_to_slot_freqs_.at(dictionary_.GetWord(new_it->term_id)).at(slot) = new_it->term_freq;
+            }
+            ++old_it;
+            ++new_it;
+        }
+    }
+    forward_index_.Replace(slot, new_entries);
+    documents_.SetStatus(slot, prepared.status);
+    documents_.SetRating(slot, prepared.rating);
+    documents_.SetLength(slot, prepared.length);
+}
+
+void SearchServer::SetStatus(int document_id, DocumentStatus status) {
+    documents_.SetStatus(documents_.GetSlot(document_id), status);
+}
+
+void SearchServer::SetRating(int document_id, int rating) {
+    documents_.SetRating(documents_.GetSlot(document_id), rating);
+}
+
+void SearchServer::CheckNewDocumentId(int document_id) const {
     if (document_id < 0) {
         throw invalid_argument("Invalid ID document " + to_string(document_id));
     }
-    if (documents_.count(document_id)) {
+    if (documents_.Find(document_id) != DocumentTable::NO_SLOT) {
         throw invalid_argument("Document with ID " + to_string(document_id) + " already exist ");
     }
-    const vector<string_view> words = SplitIntoWordsNoStop(document);
-    const double inv_word_count = 1.0 / words.size();
-    for (const string_view word : words) {
-        all_words_in_documents.push_back(std::string(word));
-        id_to_document_freqs_[document_id][all_words_in_documents.back()] += inv_word_count;
-        word_to_document_freqs_[all_words_in_documents.back()][document_id] += inv_word_count;
+}
+
+vector<ForwardIndex::Entry> SearchServer::InternWords(const PreparedDocument& document) {
+    vector<ForwardIndex::Entry> entries;
+    entries.reserve(document.word_freqs.size());
+    for (const auto& [word, term_freq] : document.word_freqs) {
+        entries.push_back({ dictionary_.Add(word), term_freq });
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-    document_id_count_.insert(document_id);
+    sort(entries.begin(), entries.end(), [](const ForwardIndex::Entry& lhs, const ForwardIndex::Entry& rhs) {
+        return lhs.term_id < rhs.term_id;
+        });
+    return entries;
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query, DocumentStatus status) const {
@@ -36,29 +136,49 @@ vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query) co
     return FindTopDocuments(execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
+Task<SearchResult> SearchServer::FindTopDocumentsAsync(LocalExecutor& executor, string raw_query,
+    DocumentStatus status, QueryLimits limits) const {
+    return FindTopDocumentsAsync(executor, move(raw_query),
+        [status](int document_id, DocumentStatus document_status, int rating) {
+            return document_status == status;
+        }, move(limits));
+}
+
 int SearchServer::GetDocumentCount() const {
     return static_cast<int>(documents_.size());
 }
 
+TermStatistics SearchServer::CollectTermStatistics(const string_view& raw_query) const {
+    array<byte, QUERY_ARENA_BUFFER_SIZE> buffer;
+    pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), GetQueryUpstream());
+    const auto query = ParseQuery(raw_query, &arena);
+    TermStatistics statistics;
+    statistics.document_count = GetDocumentCount();
+    for (const string_view& word : query.plus_words) {
+        statistics.document_freqs.emplace(word, static_cast<int>(GetDocumentFreq(word)));
+    }
+    return statistics;
+}
+
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const string_view& raw_query, int document_id) const {
-    const auto query = ParseQuery(raw_query);
+    array<byte, QUERY_ARENA_BUFFER_SIZE> buffer;
+    pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), GetQueryUpstream());
+    const auto query = ParseQuery(raw_query, &arena);
+    const size_t slot = documents_.GetSlot(document_id);
     if (any_of(query.minus_words.begin(), query.minus_words.end(),
-        [this, document_id](const string_view& word) {
-            return word_to_document_freqs_.at(word).count(document_id);
+        [this, slot](const string_view& word) {
+            return IsWordInDocument(word, slot);
         }))
     {
-        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
+        return { std::vector<std::string_view>{}, documents_.GetStatus(slot) };
     }
         vector<string_view> matched_words;
         for (const string_view& word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            if (word_to_document_freqs_.at(word).count(document_id)) {
+            if (IsWordInDocument(word, slot)) {
                 matched_words.push_back(word);
             }
         }
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, documents_.GetStatus(slot) };
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy&,
@@ -68,30 +188,38 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const std
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&,
     const string_view& raw_query, int document_id) const {
-    const auto query = ParseQuery(raw_query, false);
+    array<byte, QUERY_ARENA_BUFFER_SIZE> buffer;
+    pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), GetQueryUpstream());
+    const auto query = ParseQuery(raw_query, &arena, false);
+    const size_t slot = documents_.GetSlot(document_id);
     if (any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-        [this, document_id](const string_view& word) {
-            return word_to_document_freqs_.at(word).count(document_id);
+        [this, slot](const string_view& word) {
+            return IsWordInDocument(word, slot);
         }))
     {
-        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
+        return { std::vector<std::string_view>{}, documents_.GetStatus(slot) };
     }
         vector<string_view> matched_words(query.plus_words.size());
         auto last1 = copy_if(std::execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
-            [this, document_id](const string_view& word) {
-                return word_to_document_freqs_.at(word).count(document_id);
+            [this, slot](const string_view& word) {
+                return IsWordInDocument(word, slot);
             });
         matched_words.erase(last1, matched_words.end());
         std::sort(std::execution::par, matched_words.begin(), matched_words.end());
         auto last2 = std::unique(std::execution::par, matched_words.begin(), matched_words.end());
         matched_words.erase(last2, matched_words.end());
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, documents_.GetStatus(slot) };
 }
 
 bool SearchServer::IsStopWord(const string_view& word) const {
     return stop_words_.count(word) > 0;
 }
 
+bool SearchServer::IsWordInDocument(const string_view& word, size_t slot) const {
+    const auto it = word_to_slot_freqs_.find(word);
+    return it != word_to_slot_freqs_.end() && it->second.count(slot);
+}
+
 bool SearchServer::IsValidWord(const string_view& word) {
     return none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
@@ -131,15 +259,120 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view& text) const {
         is_minus = true;
         text = text.substr(1);
     }
-    return { text, is_minus, IsStopWord(text) };
+    if (text.size() > 1 && text.back() == '*') {
+        if (text[text.size() - 2] == '\\') {
+            return { text.substr(0, text.size() - 2), is_minus, false, QueryWordType::ESCAPED, 0, text.substr(text.size() - 1) };
+        }
+        return { text.substr(0, text.size() - 1), is_minus, false, QueryWordType::PREFIX, 0, {} };
+    }
+    const size_t tilde = text.rfind('~');
+    if (tilde != string_view::npos && tilde > 0) {
+        if (text[tilde - 1] == '\\') {
+            return { text.substr(0, tilde - 1), is_minus, false, QueryWordType::ESCAPED, 0, text.substr(tilde) };
+        }
+        const string_view edits = text.substr(tilde + 1);
+        if (all_of(edits.begin(), edits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            const int max_edits = edits.empty() ? 1 : edits.back() - '0';
+            if (edits.size() > 1 || max_edits > MAX_QUERY_EDIT_DISTANCE) {
+                throw invalid_argument("Edit distance in query word is too large");
+            }
+            return { text.substr(0, tilde), is_minus, false, QueryWordType::FUZZY, max_edits, {} };
+        }
+    }
+    return { text, is_minus, IsStopWord(text), QueryWordType::EXACT, 0, {} };
 }
 
+void SearchServer::ExpandQueryWord(const QueryWord& query_word, pmr::vector<string_view>& words) const {
+    if (query_word.is_minus) {
+        // Capping a minus pattern would let documents it should exclude through
+        const auto add_term = [this, &words](int term_id, auto...) {
+            const string_view term = dictionary_.GetWord(term_id);
+            if (GetDocumentFreq(term) > 0) {
+                words.push_back(term);
+            }
+            return true;
+        };
+        if (query_word.type == QueryWordType::PREFIX) {
+            dictionary_.ForEachWithPrefix(query_word.data, add_term);
+        }
+        else {
+            dictionary_.ForEachWithinDistance(query_word.data, query_word.max_edits, add_term);
+        }
+        return;
+    }
 
-SearchServer::Query SearchServer::ParseQuery(const string_view& text, bool sort_words) const {
-    Query result;
-    for (string_view& word : SplitIntoWordsView(text)) {
+    // Closest terms win the cap: the exact word first, then by edit distance, then by document frequency
+    struct Candidate {
+        string_view term;
+        int distance;
+        size_t document_freq;
+    };
+    pmr::vector<Candidate> candidates(words.get_allocator().resource());
+    const auto add_candidate = [this, &candidates](int term_id, int distance) {
+        const string_view term = dictionary_.GetWord(term_id);
+        if (const size_t document_freq = GetDocumentFreq(term); document_freq > 0) {
+            candidates.push_back({ term, distance, document_freq });
+        }
+    };
+    if (query_word.type == QueryWordType::PREFIX) {
+        dictionary_.ForEachWithPrefix(query_word.data, [&](int term_id) {
+            add_candidate(term_id, dictionary_.GetWord(term_id).size() == query_word.data.size() ? 0 : 1);
+            return candidates.size() < MAX_QUERY_PREFIX_CANDIDATES;
+        });
+    }
+    else {
+        // One bounded walk per distance, so a cut walk only loses the farthest terms
+        if (const int term_id = dictionary_.Find(query_word.data); term_id != TermDictionary::NO_TERM) {
+            add_candidate(term_id, 0);
+        }
+        for (int max_edits = 1; max_edits <= query_word.max_edits && candidates.size() < MAX_QUERY_TERM_EXPANSIONS;
+            ++max_edits) {
+            dictionary_.ForEachWithinDistance(query_word.data, max_edits, [&](int term_id, int distance) {
+                if (distance == max_edits) {
+                    add_candidate(term_id, distance);
+                }
+                return true;
+            }, MAX_QUERY_FUZZY_STEPS);
+        }
+    }
+    const auto is_closer = [](const Candidate& lhs, const Candidate& rhs) {
+        return tie(lhs.distance, rhs.document_freq, lhs.term) < tie(rhs.distance, lhs.document_freq, rhs.term);
+    };
+    const size_t count = min(candidates.size(), MAX_QUERY_TERM_EXPANSIONS);
+    partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), is_closer);
+    for (size_t i = 0; i < count; ++i) {
+        words.push_back(candidates[i].term);
+    }
+}
+
+size_t SearchServer::GetDocumentFreq(string_view word) const {
+    const auto it = word_to_slot_freqs_.find(word);
+    return it == word_to_slot_freqs_.end() ? 0 : it->second.size();
+}
+
+void SearchServer::AddEscapedQueryWord(const QueryWord& query_word, pmr::vector<string_view>& words) const {
+    // The literal word is not contiguous in the query text, so the query keeps the dictionary's copy;
+    // a word missing from the dictionary cannot match any document
+    string word(query_word.data);
+    word += query_word.escaped_suffix;
+    const int term_id = dictionary_.Find(word);
+    if (term_id != TermDictionary::NO_TERM && !IsStopWord(word)) {
+        words.push_back(dictionary_.GetWord(term_id));
+    }
+}
+
+SearchServer::Query SearchServer::ParseQuery(const string_view& text, pmr::memory_resource* resource,
+    bool sort_words) const {
+    Query result(resource);
+    for (string_view& word : SplitIntoWordsView(text, resource)) {
         auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
+        if (query_word.type == QueryWordType::ESCAPED) {
+            AddEscapedQueryWord(query_word, query_word.is_minus ? result.minus_words : result.plus_words);
+        }
+        else if (query_word.type != QueryWordType::EXACT) {
+            ExpandQueryWord(query_word, query_word.is_minus ? result.minus_words : result.plus_words);
+        }
+        else if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 result.minus_words.push_back(query_word.data);
             }
@@ -161,33 +394,51 @@ SearchServer::Query SearchServer::ParseQuery(const string_view& text, bool sort_
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string_view& word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeWordInverseDocumentFreq(const string_view& word, const TermStatistics* statistics) const {
+    if (statistics) {
+        const auto it = statistics->document_freqs.find(word);
+        if (it == statistics->document_freqs.end()) {
+            throw out_of_range("No statistics for query word " + string(word));
+        }
+        return log(statistics->document_count * 1.0 / it->second);
+    }
+    return log(GetDocumentCount() * 1.0 / word_to_slot_freqs_.at(word).size());
+}
+
+pmr::vector<int>::const_iterator SearchServer::begin()  const {
+    return documents_.begin();
 }
 
-set<int>::const_iterator SearchServer::begin()  const {
-    return document_id_count_.begin();
+pmr::vector<int>::const_iterator SearchServer::end()  const {
+    return documents_.end();
 }
 
-set<int>::const_iterator SearchServer::end()  const {
-    return document_id_count_.end();
+pmr::memory_resource* SearchServer::GetQueryUpstream() const {
+    if (query_resource_) {
+        return query_resource_;
+    }
+    thread_local pmr::unsynchronized_pool_resource thread_pool(pmr::pool_options{ 0, QUERY_POOL_LARGEST_BLOCK });
+    return &thread_pool;
 }
 
-const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static const map<string_view, double> empty_map;
-    if (!document_id_count_.count(document_id)) {
-        return empty_map;
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const size_t slot = documents_.Find(document_id);
+    if (slot == DocumentTable::NO_SLOT) {
+        return {};
     }
-    return id_to_document_freqs_.at(document_id);
+    return { forward_index_.Get(slot), dictionary_ };
 }
 
 void SearchServer::RemoveDocument(int document_id) {
-    for (auto& [word, freqs] : GetWordFrequencies(document_id)) {
-        word_to_document_freqs_[word].erase(document_id);
+    const size_t slot = documents_.Find(document_id);
+    if (slot == DocumentTable::NO_SLOT) {
+        return;
     }
-    documents_.erase(document_id);
-    id_to_document_freqs_.erase(document_id);
-    document_id_count_.erase(document_id);
+    for (const ForwardIndex::Entry& entry : forward_index_.Get(slot)) {
+        word_to_slot_freqs_.at(dictionary_.GetWord(entry.term_id)).erase(slot);
+    }
+    forward_index_.Remove(slot);
+    documents_.Remove(slot);
 }
 
 void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int document_id) {
@@ -195,18 +446,74 @@ void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int d
 }
 
 void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id) {
-    std::vector<const std::string_view*> words(id_to_document_freqs_.at(document_id).size());
-    transform(std::execution::par,
-        id_to_document_freqs_.at(document_id).begin(), id_to_document_freqs_.at(document_id).end(),
-        words.begin(),
-        [](auto& word) {
-            return &word.first;
-        });
-    for_each(std::execution::par, words.begin(), words.end(), [&](const string_view* word) {
-        word_to_document_freqs_[*word].erase(document_id);
+    const size_t slot = documents_.GetSlot(document_id);
+    const auto entries = forward_index_.Get(slot);
+    for_each(std::execution::par, entries.begin(), entries.end(), [&](const ForwardIndex::Entry& entry) {
+        word_to_slot_freqs_.at(dictionary_.GetWord(entry.term_id)).erase(slot);
         });
-    documents_.erase(document_id);
-    id_to_document_freqs_.erase(document_id);
-    document_id_count_.erase(document_id);
+    forward_index_.Remove(slot);
+    documents_.Remove(slot);
+}
+
+MemoryStats SearchServer::GetMemoryStats() const {
+    MemoryStats stats{
+        memory_->dictionary.GetBytesInUse(),
+        memory_->postings.GetBytesInUse(),
+        memory_->forward_index.GetBytesInUse(),
+        memory_->documents.GetBytesInUse(),
+    };
+    stats.reserved = own_index_resource_ ? own_index_resource_->reserved.GetBytesInUse() : stats.GetTotal();
+    return stats;
+}
+
+void SearchServer::SetMemoryBudget(size_t bytes) {
+    memory_budget_ = bytes;
 }
 
+size_t SearchServer::GetMemoryBudget() const {
+    return memory_budget_;
+}
+
+void SearchServer::Compact() {
+    for (auto it = word_to_slot_freqs_.begin(); it != word_to_slot_freqs_.end();) {
+        if (it->second.empty()) {
+            it = word_to_slot_freqs_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    forward_index_.Compact();
+    forward_index_.ShrinkToFit();
+    documents_.ShrinkToFit();
+    dictionary_.ShrinkToFit();
+}
+
+void SearchServer::CheckMemoryBudget() {
+    if (memory_budget_ == 0) {
+        return;
+    }
+    size_t total = GetMemoryStats().GetTotal();
+    if (total < memory_budget_) {
+        return;
+    }
+    // Compacting again cannot help until the index has changed since the last attempt
+    if (total != bytes_after_compaction_) {
+        Compact();
+        total = GetMemoryStats().GetTotal();
+        bytes_after_compaction_ = total;
+    }
+    if (total >= memory_budget_) {
+        throw MemoryBudgetExceeded("Index uses " + to_string(total) + " bytes with a budget of "
+            + to_string(memory_budget_));
+    }
+}
+
+ostream& operator<<(ostream& out, const MemoryStats& stats) {
+    return out << "{ dictionary = "s << stats.dictionary <<
+        ", postings = "s << stats.postings <<
+        ", forward_index = "s << stats.forward_index <<
+        ", documents = "s << stats.documents <<
+        ", total = "s << stats.GetTotal() <<
+        ", reserved = "s << stats.reserved << " }"s;
+}
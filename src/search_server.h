@@ -11,11 +11,75 @@
 #include <stdexcept>
 #include <execution>
 #include <string_view>
-#include <deque>
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include "allocation_counter.h"
 #include "concurrent_map.h"
+#include "document_table.h"
+#include "forward_index.h"
+#include "local_executor.h"
+#include "query_limits.h"
+#include "query_profile.h"
+#include "task.h"
+#include "term_dictionary.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPSILON = 1e-6;
+const size_t QUERY_ARENA_BUFFER_SIZE = 4096;
+const int MAX_QUERY_EDIT_DISTANCE = 2;
+const size_t MAX_QUERY_TERM_EXPANSIONS = 64;
+// A plus prefix pattern ranks at most this many of its shortest indexed completions
+const size_t MAX_QUERY_PREFIX_CANDIDATES = 256;
+// Steps a plus fuzzy pattern may spend per edit distance (see TermDictionary::ForEachWithinDistance)
+const size_t MAX_QUERY_FUZZY_STEPS = 4096;
+const size_t INDEX_POOL_LARGEST_BLOCK = 4096;
+const size_t QUERY_POOL_LARGEST_BLOCK = 64 << 10;
+
+struct SearchServerResources {
+    // Long-lived index structures, must be thread-safe: RemoveDocument(par) releases postings
+    // from several threads at once; the server owns a synchronized pool when null
+    std::pmr::memory_resource* index = nullptr;
+    // Upstream for per-query arenas, must be thread-safe; a per-thread pool when null, which keeps
+    // arena chunks up to QUERY_POOL_LARGEST_BLOCK for the life of the thread and frees larger ones
+    std::pmr::memory_resource* query = nullptr;
+};
+
+struct TermStatistics {
+    int document_count = 0;
+    std::map<std::string, int, std::less<>> document_freqs;
+};
+
+// Bytes currently allocated by each part of the index
+struct MemoryStats {
+    size_t dictionary = 0;
+    size_t postings = 0;
+    size_t forward_index = 0;
+    size_t documents = 0;
+    // What the server's own pool holds from the system: the bytes in use plus freed blocks kept
+    // for reuse and pool bookkeeping; equals GetTotal() for a caller-supplied index resource
+    size_t reserved = 0;
+
+    size_t GetTotal() const {
+        return dictionary + postings + forward_index + documents;
+    }
+};
+
+std::ostream& operator<<(std::ostream& out, const MemoryStats& stats);
+
+class MemoryBudgetExceeded : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+inline bool HasHigherRelevance(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        return lhs.rating > rhs.rating;
+    }
+    else {
+        return lhs.relevance > rhs.relevance;
+    }
+}
 
 template <typename StringContainer>
 std::set<std::string_view> MakeUniqueNonEmptyStrings(const StringContainer& strings);
@@ -24,11 +88,37 @@ class SearchServer {
 
 public:
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
-    explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(const StringContainer& stop_words, const SearchServerResources& resources = {});
+    explicit SearchServer(const std::string& stop_words_text, const SearchServerResources& resources = {});
+
+    // Move-only, unlike before the index moved to memory resources: postings view words owned by the
+    // dictionary and every container stays bound to the resources chosen at construction
+    SearchServer(const SearchServer&) = delete;
+    SearchServer& operator=(const SearchServer&) = delete;
+    SearchServer(SearchServer&& other);
+    SearchServer& operator=(SearchServer&&) = delete;
 
     void AddDocument(int document_id, const std::string_view& document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Tokenized document whose words view the source text; preparing is thread-safe, adding is not
+    struct PreparedDocument {
+        int id;
+        DocumentStatus status;
+        int rating;
+        int length;
+        std::vector<std::pair<std::string_view, double>> word_freqs;
+    };
+
+    PreparedDocument PrepareDocument(int document_id, const std::string_view& document, DocumentStatus status,
+        const std::vector<int>& ratings) const;
+    void AddPreparedDocument(const PreparedDocument& document);
+
+    // Touches only the postings of terms that appeared, disappeared or changed frequency
+    void UpdateDocument(int document_id, const std::string_view& document, DocumentStatus status,
+        const std::vector<int>& ratings);
+    void SetStatus(int document_id, DocumentStatus status);
+    void SetRating(int document_id, int rating);
+
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate) const;
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
@@ -43,6 +133,23 @@ public:
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query) const;
 
+    TermStatistics CollectTermStatistics(const std::string_view& raw_query) const;
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+        DocumentPredicate document_predicate, const TermStatistics& statistics) const;
+
+    // Stops scanning postings once the limits run out and returns what was scored so far;
+    // minus words are always applied in full
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    SearchResult FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+        DocumentPredicate document_predicate, const QueryLimits& limits) const;
+    // The server must outlive the returned task; the query runs on an executor thread
+    template <typename DocumentPredicate>
+    Task<SearchResult> FindTopDocumentsAsync(LocalExecutor& executor, std::string raw_query,
+        DocumentPredicate document_predicate, QueryLimits limits = {}) const;
+    Task<SearchResult> FindTopDocumentsAsync(LocalExecutor& executor, std::string raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL, QueryLimits limits = {}) const;
+
     int GetDocumentCount() const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view& raw_query,
         int document_id) const;
@@ -51,55 +158,136 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&,
         const std::string_view& raw_query, int document_id) const;
 
-    std::set<int>::const_iterator begin() const;
-    std::set<int>::const_iterator end() const;
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    std::pmr::vector<int>::const_iterator begin() const;
+    std::pmr::vector<int>::const_iterator end() const;
+    // Valid only until the next Add, Remove or UpdateDocument: those may compact or reallocate the forward index
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
     void RemoveDocument(const std::execution::parallel_policy&, int document_id);
 
+    MemoryStats GetMemoryStats() const;
+    // Adding or updating a document while the index has at least this many bytes in use (GetTotal(),
+    // not reserved: freed pool blocks are reused by later documents) first compacts the index and
+    // then throws MemoryBudgetExceeded if that did not help; 0 disables the check
+    void SetMemoryBudget(size_t bytes);
+    size_t GetMemoryBudget() const;
+    // Drops empty posting lists and forward-index garbage and releases spare container capacity.
+    // Arrays larger than INDEX_POOL_LARGEST_BLOCK go back to the system; freed smaller blocks,
+    // such as posting nodes, stay reserved by the pool for later documents
+    void Compact();
+
 private:
 
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
+    // Shared with moved-from servers: their containers may still hold memory (a moved-from
+    // std::deque allocates a fresh map) and must be able to release it, so a defaulted move
+    // that hands the pool over would leave them freeing into a destroyed resource
+    struct OwnIndexResource {
+        OwnIndexResource()
+            : pool(std::pmr::pool_options{ 0, INDEX_POOL_LARGEST_BLOCK }, &reserved) {}
+
+        // Counts below the pool: blocks the pool keeps after they are freed are still reserved
+        AllocationCounter reserved{ std::pmr::new_delete_resource() };
+        std::pmr::synchronized_pool_resource pool;
     };
 
-    std::set<std::string, std::less<>> stop_words_;
-    std::deque<std::string> all_words_in_documents;
+    std::shared_ptr<OwnIndexResource> own_index_resource_;
+    std::pmr::memory_resource* index_resource_;
+    std::pmr::memory_resource* query_resource_;
 
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_id_count_;
-    std::map<int, std::map<std::string_view, double>> id_to_document_freqs_;
+    struct IndexMemory {
+        explicit IndexMemory(std::pmr::memory_resource* upstream)
+            : dictionary(upstream), postings(upstream), forward_index(upstream), documents(upstream) {}
 
+        AllocationCounter dictionary;
+        AllocationCounter postings;
+        AllocationCounter forward_index;
+        AllocationCounter documents;
+    };
+
+    std::shared_ptr<IndexMemory> memory_;
+    size_t memory_budget_ = 0;
+    size_t bytes_after_compaction_ = 0;
+
+    std::pmr::set<std::pmr::string, std::less<>> stop_words_;
+    TermDictionary dictionary_;
+
+    // Postings are keyed by document slot; the slot also indexes the forward index
+    std::pmr::map<std::string_view, std::pmr::map<size_t, double>> word_to_slot_freqs_;
+    DocumentTable documents_;
+    ForwardIndex forward_index_;
+
+    explicit SearchServer(const SearchServerResources& resources);
+    std::pmr::memory_resource* GetQueryUpstream() const;
+
+    void CheckNewDocumentId(int document_id) const;
+    void CheckMemoryBudget();
+    std::vector<ForwardIndex::Entry> InternWords(const PreparedDocument& document);
     bool IsStopWord(const std::string_view& word) const;
+    bool IsWordInDocument(const std::string_view& word, size_t slot) const;
     static bool IsValidWord(const std::string_view& word);
     std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view& text) const;
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    enum class QueryWordType {
+        EXACT,
+        PREFIX,
+        FUZZY,
+        ESCAPED,
+    };
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        QueryWordType type = QueryWordType::EXACT;
+        int max_edits = 0;
+        // An escaped word is data followed by this suffix with the backslash between them dropped
+        std::string_view escaped_suffix;
     };
     QueryWord ParseQueryWord(std::string_view& text) const;
+    void ExpandQueryWord(const QueryWord& query_word, std::pmr::vector<std::string_view>& words) const;
+    size_t GetDocumentFreq(std::string_view word) const;
+    void AddEscapedQueryWord(const QueryWord& query_word, std::pmr::vector<std::string_view>& words) const;
 
     struct Query {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+        explicit Query(std::pmr::memory_resource* resource)
+            : plus_words(resource), minus_words(resource) {}
+
+        std::pmr::vector<std::string_view> plus_words;
+        std::pmr::vector<std::string_view> minus_words;
+    };
+
+    struct QueryContext {
+        std::pmr::memory_resource* resource;
+        QueryProfiler& profiler;
+        const TermStatistics* statistics = nullptr;
+        const QueryBudget* budget = nullptr;
+
+        bool IsExhausted() const {
+            return budget && budget->IsExhausted();
+        }
     };
 
-    Query ParseQuery(const std::string_view& text, bool sort_words = true) const;
-    double ComputeWordInverseDocumentFreq(const std::string_view& word) const;
+    Query ParseQuery(const std::string_view& text, std::pmr::memory_resource* resource, bool sort_words = true) const;
+    double ComputeWordInverseDocumentFreq(const std::string_view& word, const TermStatistics* statistics) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+        DocumentPredicate document_predicate, const TermStatistics* statistics, const QueryBudget* budget = nullptr) const;
+
+    // Feeds (slot, relevance) of the word's postings that pass the predicate to consume
+    template <typename DocumentPredicate, typename Consumer>
+    void ScanPostings(const std::string_view& word, DocumentPredicate& document_predicate,
+        const QueryContext& context, Consumer consume) const;
 
     template <typename DocumentPredicate>
     std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query,
-        DocumentPredicate document_predicate) const;
+        DocumentPredicate document_predicate, const QueryContext& context) const;
     template <typename DocumentPredicate>
     std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query,
-        DocumentPredicate document_predicate) const;
+        DocumentPredicate document_predicate, const QueryContext& context) const;
 };
 
 template <typename StringContainer>
@@ -114,14 +302,15 @@ std::set<std::string_view> MakeUniqueNonEmptyStrings(const StringContainer& stri
 }
 
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
+SearchServer::SearchServer(const StringContainer& stop_words, const SearchServerResources& resources)
+    : SearchServer(resources)
 {
     std::set<std::string_view> vec = MakeUniqueNonEmptyStrings(stop_words);
     for (auto& word : vec) {
         if (!IsValidWord(word)) {
             throw std::invalid_argument("Invalid stop word");
         }
-        stop_words_.insert(std::string(word));
+        stop_words_.emplace(word);
     }
 }
 
@@ -149,17 +338,45 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw
 template <typename ExecutionPolicy, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
     const std::string_view& raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-    std::sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
+    return FindTopDocuments(policy, raw_query, document_predicate, nullptr);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const std::string_view& raw_query, DocumentPredicate document_predicate, const TermStatistics& statistics) const {
+    return FindTopDocuments(policy, raw_query, document_predicate, &statistics);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+SearchResult SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const std::string_view& raw_query, DocumentPredicate document_predicate, const QueryLimits& limits) const {
+    const QueryBudget budget(limits);
+    auto documents = FindTopDocuments(policy, raw_query, document_predicate, nullptr, &budget);
+    return { std::move(documents), !budget.WasExhausted() };
+}
+
+template <typename DocumentPredicate>
+Task<SearchResult> SearchServer::FindTopDocumentsAsync(LocalExecutor& executor, std::string raw_query,
+    DocumentPredicate document_predicate, QueryLimits limits) const {
+    co_await executor.Schedule();
+    co_return FindTopDocuments(std::execution::seq, raw_query, document_predicate, limits);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const std::string_view& raw_query, DocumentPredicate document_predicate, const TermStatistics* statistics,
+    const QueryBudget* budget) const {
+    QueryProfiler profiler;
+    std::array<std::byte, QUERY_ARENA_BUFFER_SIZE> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), GetQueryUpstream());
+    Query query(&arena);
+    {
+        QueryStageTimer timer(profiler, QueryStage::PARSE);
+        query = ParseQuery(raw_query, &arena);
+    }
+    auto matched_documents = FindAllDocuments(policy, query, document_predicate, { &arena, profiler, statistics, budget });
+    QueryStageTimer timer(profiler, QueryStage::TOP_K);
+    std::sort(policy, matched_documents.begin(), matched_documents.end(), HasHigherRelevance);
 
     if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
         matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
@@ -167,62 +384,93 @@ std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& poli
     return matched_documents;
 }
 
+template <typename DocumentPredicate, typename Consumer>
+void SearchServer::ScanPostings(const std::string_view& word, DocumentPredicate& document_predicate,
+    const QueryContext& context, Consumer consume) const {
+    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word, context.statistics);
+    size_t scanned = 0;
+    for (const auto& [slot, term_freq] : word_to_slot_freqs_.at(word)) {
+        if (document_predicate(documents_.GetId(slot), documents_.GetStatus(slot), documents_.GetRating(slot))) {
+            consume(slot, term_freq * inverse_document_freq);
+        }
+        if (++scanned % POSTING_BLOCK_SIZE == 0 && context.IsExhausted()) {
+            break;
+        }
+    }
+    context.profiler.AddCounter(QueryCounter::POSTINGS_SCANNED, scanned);
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&,
-    const Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
+    const Query& query, DocumentPredicate document_predicate, const QueryContext& context) const {
+    QueryProfiler& profiler = context.profiler;
+    std::pmr::map<size_t, double> slot_to_relevance(context.resource);
     for (const std::string_view& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        if (word_to_slot_freqs_.count(word) == 0) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
-            }
+        if (context.IsExhausted()) {
+            break;
         }
+        QueryStageTimer timer(profiler, QueryStage::POSTING_SCAN);
+        ScanPostings(word, document_predicate, context, [&](size_t slot, double relevance) {
+            slot_to_relevance[slot] += relevance;
+        });
     }
-    for (const std::string_view& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        for (const auto& [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+    profiler.AddCounter(QueryCounter::DOCUMENTS_SCORED, slot_to_relevance.size());
+    {
+        QueryStageTimer timer(profiler, QueryStage::MINUS_FILTER);
+        for (const std::string_view& word : query.minus_words) {
+            if (word_to_slot_freqs_.count(word) == 0) {
+                continue;
+            }
+            for (const auto& [slot, _] : word_to_slot_freqs_.at(word)) {
+                slot_to_relevance.erase(slot);
+            }
         }
     }
+    QueryStageTimer timer(profiler, QueryStage::RESULT_BUILD);
     std::vector<Document> matched_documents;
-    for (const auto& [document_id, relevance] : document_to_relevance) {
+    for (const auto& [slot, relevance] : slot_to_relevance) {
         matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
+            { documents_.GetId(slot), relevance, documents_.GetRating(slot) });
     }
     return matched_documents;
 }
 
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&,
-    const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(1000);
+    const Query& query, DocumentPredicate document_predicate, const QueryContext& context) const {
+    QueryProfiler& profiler = context.profiler;
+    ConcurrentMap<size_t, double> slot_to_relevance;
     std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(),
         [&](const std::string_view& word) {
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                }
-            }
-        });
-    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-        [&](const std::string_view& word) {
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+            if (word_to_slot_freqs_.count(word) == 0 || context.IsExhausted()) {
+                return;
             }
+            QueryStageTimer timer(profiler, QueryStage::POSTING_SCAN);
+            ScanPostings(word, document_predicate, context, [&](size_t slot, double relevance) {
+                slot_to_relevance.Add(slot, relevance);
+            });
         });
+    profiler.AddCounter(QueryCounter::DOCUMENTS_SCORED, slot_to_relevance.size());
+    {
+        QueryStageTimer timer(profiler, QueryStage::MINUS_FILTER);
+        std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
+            [&](const std::string_view& word) {
+                if (word_to_slot_freqs_.count(word) == 0) {
+                    return;
+                }
+                for (const auto [slot, _] : word_to_slot_freqs_.at(word)) {
+                    slot_to_relevance.erase(slot);
+                }
+            });
+    }
+    QueryStageTimer timer(profiler, QueryStage::RESULT_BUILD);
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
+    for (const auto& [slot, relevance] : slot_to_relevance.Extract()) {
         matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
+            { documents_.GetId(slot), relevance, documents_.GetRating(slot) });
     }
     return matched_documents;
 }
\ No newline at end of file
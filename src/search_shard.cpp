@@ -0,0 +1,52 @@
+#include "search_shard.h"
+
+using namespace std;
+
+LocalShard::LocalShard(SearchServer search_server)
+    : search_server_(move(search_server)) {}
+
+void LocalShard::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    search_server_.AddDocument(document_id, document, status, ratings);
+}
+
+void LocalShard::RemoveDocument(int document_id) {
+    search_server_.RemoveDocument(document_id);
+}
+
+void LocalShard::UpdateDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    search_server_.UpdateDocument(document_id, document, status, ratings);
+}
+
+void LocalShard::SetStatus(int document_id, DocumentStatus status) {
+    search_server_.SetStatus(document_id, status);
+}
+
+void LocalShard::SetRating(int document_id, int rating) {
+    search_server_.SetRating(document_id, rating);
+}
+
+int LocalShard::GetDocumentCount() const {
+    return search_server_.GetDocumentCount();
+}
+
+TermStatistics LocalShard::CollectTermStatistics(string_view raw_query) const {
+    return search_server_.CollectTermStatistics(raw_query);
+}
+
+vector<Document> LocalShard::FindTopDocuments(string_view raw_query, DocumentStatus status,
+    const TermStatistics& statistics) const {
+    return search_server_.FindTopDocuments(execution::seq, raw_query,
+        [status](int document_id, DocumentStatus document_status, int rating) {
+            return document_status == status;
+        }, statistics);
+}
+
+vector<Document> LocalShard::FindTopDocuments(string_view raw_query, const DocumentFilter& document_filter,
+    const TermStatistics& statistics) const {
+    return search_server_.FindTopDocuments(execution::seq, raw_query, document_filter, statistics);
+}
+
+tuple<vector<string>, DocumentStatus> LocalShard::MatchDocument(string_view raw_query, int document_id) const {
+    const auto [words, status] = search_server_.MatchDocument(raw_query, document_id);
+    return { vector<string>(words.begin(), words.end()), status };
+}
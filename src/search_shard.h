@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+using DocumentFilter = std::function<bool(int document_id, DocumentStatus status, int rating)>;
+
+class SearchShard {
+public:
+    virtual ~SearchShard() = default;
+
+    virtual void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) = 0;
+    virtual void RemoveDocument(int document_id) = 0;
+    virtual void UpdateDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) = 0;
+    virtual void SetStatus(int document_id, DocumentStatus status) = 0;
+    virtual void SetRating(int document_id, int rating) = 0;
+    virtual int GetDocumentCount() const = 0;
+
+    virtual TermStatistics CollectTermStatistics(std::string_view raw_query) const = 0;
+    virtual std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        const TermStatistics& statistics) const = 0;
+    virtual std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& document_filter,
+        const TermStatistics& statistics) const = 0;
+    // Returns owned words: a remote shard has no storage the views could point into
+    virtual std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query,
+        int document_id) const = 0;
+};
+
+class LocalShard : public SearchShard {
+public:
+    explicit LocalShard(SearchServer search_server);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) override;
+    void RemoveDocument(int document_id) override;
+    void UpdateDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) override;
+    void SetStatus(int document_id, DocumentStatus status) override;
+    void SetRating(int document_id, int rating) override;
+    int GetDocumentCount() const override;
+
+    TermStatistics CollectTermStatistics(std::string_view raw_query) const override;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        const TermStatistics& statistics) const override;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& document_filter,
+        const TermStatistics& statistics) const override;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query,
+        int document_id) const override;
+
+private:
+    SearchServer search_server_;
+};
@@ -0,0 +1,142 @@
+#include "sharded_search_server.h"
+#include "string_processing.h"
+
+using namespace std;
+
+ShardedSearchServer::ShardedSearchServer(vector<unique_ptr<SearchShard>> shards)
+    : shards_(move(shards)) {
+    if (shards_.empty()) {
+        throw invalid_argument("Sharded search server needs at least one shard");
+    }
+}
+
+ShardedSearchServer::ShardedSearchServer(const string& stop_words_text, size_t shard_count)
+    : ShardedSearchServer(MakeLocalShards(SplitIntoWordsView(stop_words_text), shard_count)) {}
+
+vector<unique_ptr<SearchShard>> ShardedSearchServer::MakeLocalShards(const vector<string_view>& stop_words,
+    size_t shard_count) {
+    vector<unique_ptr<SearchShard>> shards;
+    shards.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards.push_back(make_unique<LocalShard>(SearchServer(stop_words)));
+    }
+    return shards;
+}
+
+SearchShard& ShardedSearchServer::GetShard(int document_id) const {
+    const uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(document_id)) * 0x9E3779B97F4A7C15ull;
+    return *shards_[(hash >> 32) % shards_.size()];
+}
+
+SearchShard& ShardedSearchServer::GetExistingShard(int document_id) const {
+    if (!document_ids_.count(document_id)) {
+        throw out_of_range("Document with ID " + to_string(document_id) + " not found");
+    }
+    return GetShard(document_id);
+}
+
+void ShardedSearchServer::AddDocument(int document_id, const string_view& document, DocumentStatus status,
+    const vector<int>& ratings) {
+    if (document_ids_.count(document_id)) {
+        throw invalid_argument("Document with ID " + to_string(document_id) + " already exist ");
+    }
+    GetShard(document_id).AddDocument(document_id, document, status, ratings);
+    document_ids_.insert(document_id);
+}
+
+void ShardedSearchServer::UpdateDocument(int document_id, const string_view& document, DocumentStatus status,
+    const vector<int>& ratings) {
+    GetExistingShard(document_id).UpdateDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::SetStatus(int document_id, DocumentStatus status) {
+    GetExistingShard(document_id).SetStatus(document_id, status);
+}
+
+void ShardedSearchServer::SetRating(int document_id, int rating) {
+    GetExistingShard(document_id).SetRating(document_id, rating);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view& raw_query, DocumentStatus status) const {
+    return FindTopDocuments(execution::seq, raw_query, status);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view& raw_query) const {
+    return FindTopDocuments(execution::seq, raw_query, DocumentStatus::ACTUAL);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(document_ids_.size());
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+tuple<vector<string>, DocumentStatus> ShardedSearchServer::MatchDocument(const string_view& raw_query,
+    int document_id) const {
+    return GetShard(document_id).MatchDocument(raw_query, document_id);
+}
+
+tuple<vector<string>, DocumentStatus> ShardedSearchServer::MatchDocument(const execution::sequenced_policy&,
+    const string_view& raw_query, int document_id) const {
+    return MatchDocument(raw_query, document_id);
+}
+
+tuple<vector<string>, DocumentStatus> ShardedSearchServer::MatchDocument(const execution::parallel_policy&,
+    const string_view& raw_query, int document_id) const {
+    return MatchDocument(raw_query, document_id);
+}
+
+set<int>::const_iterator ShardedSearchServer::begin() const {
+    return document_ids_.begin();
+}
+
+set<int>::const_iterator ShardedSearchServer::end() const {
+    return document_ids_.end();
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    if (!document_ids_.count(document_id)) {
+        return;
+    }
+    GetShard(document_id).RemoveDocument(document_id);
+    document_ids_.erase(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(const execution::sequenced_policy&, int document_id) {
+    RemoveDocument(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
+    if (!document_ids_.count(document_id)) {
+        throw out_of_range("Document with ID " + to_string(document_id) + " not found");
+    }
+    RemoveDocument(document_id);
+}
+
+vector<Document> ShardedSearchServer::MergeTopDocuments(const vector<vector<Document>>& shard_documents) {
+    struct Head {
+        size_t shard;
+        size_t position;
+    };
+    const auto is_lower = [&shard_documents](const Head& lhs, const Head& rhs) {
+        return HasHigherRelevance(shard_documents[rhs.shard][rhs.position], shard_documents[lhs.shard][lhs.position]);
+    };
+    priority_queue<Head, vector<Head>, decltype(is_lower)> heads(is_lower);
+    for (size_t shard = 0; shard < shard_documents.size(); ++shard) {
+        if (!shard_documents[shard].empty()) {
+            heads.push({ shard, 0 });
+        }
+    }
+    vector<Document> result;
+    while (!heads.empty() && result.size() < static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT)) {
+        const Head head = heads.top();
+        heads.pop();
+        result.push_back(shard_documents[head.shard][head.position]);
+        if (head.position + 1 < shard_documents[head.shard].size()) {
+            heads.push({ head.shard, head.position + 1 });
+        }
+    }
+    return result;
+}
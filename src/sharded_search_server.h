@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+#include "search_shard.h"
+
+class ShardedSearchServer {
+public:
+    explicit ShardedSearchServer(std::vector<std::unique_ptr<SearchShard>> shards);
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count);
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count);
+
+    void AddDocument(int document_id, const std::string_view& document, DocumentStatus status, const std::vector<int>& ratings);
+    void UpdateDocument(int document_id, const std::string_view& document, DocumentStatus status,
+        const std::vector<int>& ratings);
+    void SetStatus(int document_id, DocumentStatus status);
+    void SetRating(int document_id, int rating);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+        DocumentPredicate document_predicate) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+        DocumentStatus status) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query) const;
+
+    int GetDocumentCount() const;
+    size_t GetShardCount() const;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string_view& raw_query,
+        int document_id) const;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&,
+        const std::string_view& raw_query, int document_id) const;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&,
+        const std::string_view& raw_query, int document_id) const;
+
+    std::set<int>::const_iterator begin() const;
+    std::set<int>::const_iterator end() const;
+
+    void RemoveDocument(int document_id);
+    void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
+    void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+
+private:
+    std::vector<std::unique_ptr<SearchShard>> shards_;
+    std::set<int> document_ids_;
+
+    static std::vector<std::unique_ptr<SearchShard>> MakeLocalShards(const std::vector<std::string_view>& stop_words,
+        size_t shard_count);
+    SearchShard& GetShard(int document_id) const;
+    SearchShard& GetExistingShard(int document_id) const;
+
+    template <typename Result, typename ExecutionPolicy, typename ShardCall>
+    std::vector<Result> Scatter(const ExecutionPolicy& policy, ShardCall shard_call) const;
+    template <typename ExecutionPolicy>
+    TermStatistics CollectTermStatistics(const ExecutionPolicy& policy, const std::string_view& raw_query) const;
+    template <typename ExecutionPolicy, typename ShardSearch>
+    std::vector<Document> ScatterGather(const ExecutionPolicy& policy, const std::string_view& raw_query,
+        ShardSearch shard_search) const;
+    static std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& shard_documents);
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, size_t shard_count)
+    : ShardedSearchServer(MakeLocalShards(std::vector<std::string_view>(std::begin(stop_words), std::end(stop_words)),
+        shard_count)) {}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view& raw_query,
+    DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const std::string_view& raw_query, DocumentPredicate document_predicate) const {
+    const DocumentFilter document_filter = document_predicate;
+    return ScatterGather(policy, raw_query, [&](const SearchShard& shard, const TermStatistics& statistics) {
+        return shard.FindTopDocuments(raw_query, document_filter, statistics);
+        });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const std::string_view& raw_query, DocumentStatus status) const {
+    return ScatterGather(policy, raw_query, [&](const SearchShard& shard, const TermStatistics& statistics) {
+        return shard.FindTopDocuments(raw_query, status, statistics);
+        });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const std::string_view& raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename Result, typename ExecutionPolicy, typename ShardCall>
+std::vector<Result> ShardedSearchServer::Scatter(const ExecutionPolicy& policy, ShardCall shard_call) const {
+    std::vector<Result> results(shards_.size());
+    std::vector<std::exception_ptr> errors(shards_.size());
+    std::vector<size_t> shard_indexes(shards_.size());
+    std::iota(shard_indexes.begin(), shard_indexes.end(), 0);
+    // An exception escaping an algorithm with an execution policy would call std::terminate
+    std::for_each(policy, shard_indexes.begin(), shard_indexes.end(), [&](size_t index) {
+        try {
+            results[index] = shard_call(*shards_[index]);
+        }
+        catch (...) {
+            errors[index] = std::current_exception();
+        }
+        });
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return results;
+}
+
+template <typename ExecutionPolicy>
+TermStatistics ShardedSearchServer::CollectTermStatistics(const ExecutionPolicy& policy,
+    const std::string_view& raw_query) const {
+    const auto shard_statistics = Scatter<TermStatistics>(policy, [&raw_query](const SearchShard& shard) {
+        return shard.CollectTermStatistics(raw_query);
+        });
+    TermStatistics statistics;
+    for (const TermStatistics& shard : shard_statistics) {
+        statistics.document_count += shard.document_count;
+        for (const auto& [word, document_freq] : shard.document_freqs) {
+            statistics.document_freqs[word] += document_freq;
+        }
+    }
+    return statistics;
+}
+
+template <typename ExecutionPolicy, typename ShardSearch>
+std::vector<Document> ShardedSearchServer::ScatterGather(const ExecutionPolicy& policy,
+    const std::string_view& raw_query, ShardSearch shard_search) const {
+    const TermStatistics statistics = CollectTermStatistics(policy, raw_query);
+    const auto shard_documents = Scatter<std::vector<Document>>(policy, [&](const SearchShard& shard) {
+        return shard_search(shard, statistics);
+        });
+    return MergeTopDocuments(shard_documents);
+}
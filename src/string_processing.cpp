@@ -2,8 +2,8 @@
 
 using namespace std;
 
-vector<string_view> SplitIntoWordsView(string_view str) {
-    vector<string_view> result;
+template <typename Container>
+static void AppendWords(string_view str, Container& result) {
     const int64_t pos_end = str.npos;
     str.remove_prefix(min(str.size(), str.find_first_not_of(" ")));
     while (!str.empty()) {
@@ -11,5 +11,16 @@ vector<string_view> SplitIntoWordsView(string_view str) {
         result.push_back(space == pos_end ? str.substr(0, pos_end) : str.substr(0, space));
         str.remove_prefix(min(str.size(), str.find_first_not_of(" ", space)));
     }
+}
+
+vector<string_view> SplitIntoWordsView(string_view str) {
+    vector<string_view> result;
+    AppendWords(str, result);
+    return result;
+}
+
+pmr::vector<string_view> SplitIntoWordsView(string_view str, pmr::memory_resource* resource) {
+    pmr::vector<string_view> result(resource);
+    AppendWords(str, result);
     return result;
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include<memory_resource>
 #include<vector>
 #include<string_view>
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str);
+std::pmr::vector<std::string_view> SplitIntoWordsView(std::string_view str, std::pmr::memory_resource* resource);
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <semaphore>
+#include <type_traits>
+#include <utility>
+
+// Lazily started coroutine; awaiting it runs the body and resumes the awaiter when it finishes
+template <typename T>
+class Task {
+public:
+    static_assert(!std::is_void_v<T> && !std::is_reference_v<T>, "Task holds a value");
+
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    const auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+
+        template <typename Value>
+        void return_value(Value&& result) {
+            value.emplace(std::forward<Value>(result));
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    Task(Task&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&&) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+
+    T await_resume() {
+        if (handle_.promise().exception) {
+            std::rethrow_exception(handle_.promise().exception);
+        }
+        return std::move(*handle_.promise().value);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : handle_(handle) {}
+};
+
+namespace task_detail {
+
+struct DetachedCoroutine {
+    struct promise_type {
+        DetachedCoroutine get_return_object() {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+template <typename T>
+struct SyncWaitState {
+    std::binary_semaphore done{ 0 };
+    std::optional<T> value;
+    std::exception_ptr exception;
+};
+
+// The frame shares the state: the waiter may return as soon as release() wakes it, while this thread is still inside it
+template <typename T>
+DetachedCoroutine RunSyncWait(Task<T>& task, std::shared_ptr<SyncWaitState<T>> state) {
+    try {
+        state->value.emplace(co_await std::move(task));
+    }
+    catch (...) {
+        state->exception = std::current_exception();
+    }
+    state->done.release();
+}
+
+}  // namespace task_detail
+
+// Blocks the calling thread until the task finishes, wherever it gets resumed
+template <typename T>
+T SyncWait(Task<T> task) {
+    const auto state = std::make_shared<task_detail::SyncWaitState<T>>();
+    task_detail::RunSyncWait(task, state);
+    state->done.acquire();
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+    return std::move(*state->value);
+}
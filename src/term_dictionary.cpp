@@ -0,0 +1,89 @@
+#include "term_dictionary.h"
+
+using namespace std;
+
+TermDictionary::TermDictionary(pmr::memory_resource* resource)
+    : words_(resource), nodes_(1, Node{}, resource) {}
+
+int TermDictionary::Add(string_view word) {
+    int node = 0;
+    for (const char label : word) {
+        int* link = &nodes_[node].first_child;
+        while (*link != NO_NODE && IsLabelLess(nodes_[*link].label, label)) {
+            link = &nodes_[*link].next_sibling;
+        }
+        if (*link == NO_NODE || nodes_[*link].label != label) {
+            const int child = static_cast<int>(nodes_.size());
+            const int next_sibling = *link;
+            *link = child;
+            nodes_.push_back({ NO_NODE, next_sibling, NO_TERM, label });
+            node = child;
+        }
+        else {
+            node = *link;
+        }
+    }
+    if (nodes_[node].term_id != NO_TERM) {
+        return nodes_[node].term_id;
+    }
+    const int term_id = static_cast<int>(words_.size());
+    nodes_[node].term_id = term_id;
+    words_.emplace_back(word);
+    if (nodes_.size() >= laid_out_node_count_ * 2) {
+        Relayout();
+    }
+    return term_id;
+}
+
+int TermDictionary::Find(string_view word) const {
+    const int node = FindNode(word);
+    return node == NO_NODE ? NO_TERM : nodes_[node].term_id;
+}
+
+string_view TermDictionary::GetWord(int term_id) const {
+    return words_[term_id];
+}
+
+size_t TermDictionary::size() const {
+    return words_.size();
+}
+
+void TermDictionary::Relayout() {
+    pmr::vector<Node> nodes(nodes_.get_allocator());
+    nodes.reserve(nodes_.size());
+    nodes.push_back(nodes_[0]);
+    for (size_t position = 0; position < nodes.size(); ++position) {
+        const int first_child = nodes[position].first_child;
+        if (first_child == NO_NODE) {
+            continue;
+        }
+        nodes[position].first_child = static_cast<int>(nodes.size());
+        for (int child = first_child; child != NO_NODE; child = nodes_[child].next_sibling) {
+            Node& node = nodes.emplace_back(nodes_[child]);
+            if (node.next_sibling != NO_NODE) {
+                node.next_sibling = static_cast<int>(nodes.size());
+            }
+        }
+    }
+    nodes_ = move(nodes);
+    laid_out_node_count_ = nodes_.size();
+}
+
+void TermDictionary::ShrinkToFit() {
+    // words_ stays as is: shrinking a deque moves its strings, and views into short ones would dangle
+    nodes_.shrink_to_fit();
+}
+
+int TermDictionary::FindNode(string_view word, int start) const {
+    int node = start;
+    for (const char label : word) {
+        node = nodes_[node].first_child;
+        while (node != NO_NODE && IsLabelLess(nodes_[node].label, label)) {
+            node = nodes_[node].next_sibling;
+        }
+        if (node == NO_NODE || nodes_[node].label != label) {
+            return NO_NODE;
+        }
+    }
+    return node;
+}
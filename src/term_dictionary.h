@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TermDictionary {
+public:
+    static constexpr int NO_TERM = -1;
+
+    explicit TermDictionary(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    int Add(std::string_view word);
+    int Find(std::string_view word) const;
+    std::string_view GetWord(int term_id) const;
+    size_t size() const;
+    void ShrinkToFit();
+
+    // Visitors receive term ids and return false to stop the walk; prefix matches come breadth-first,
+    // shorter words before longer ones and in byte order within a length
+    template <typename Visitor>
+    void ForEachWithPrefix(std::string_view prefix, Visitor visitor) const;
+    // Levenshtein distance over UTF-8 code points; visitors also receive the distance. The trie walk
+    // is cut once a DP row exceeds max_edits and turns into exact suffix lookups once it reaches it.
+    // Each DP row and each trie level a suffix lookup descends costs a step; the walk returns false
+    // when it ran out of max_steps before visiting every match
+    template <typename Visitor>
+    bool ForEachWithinDistance(std::string_view word, int max_edits, Visitor visitor, size_t max_steps = SIZE_MAX) const;
+
+private:
+    static constexpr int NO_NODE = -1;
+
+    // Left-child right-sibling trie; siblings are kept sorted by unsigned label and, after
+    // each relayout, stored contiguously in breadth-first order
+    struct Node {
+        int first_child = NO_NODE;
+        int next_sibling = NO_NODE;
+        int term_id = NO_TERM;
+        char label = 0;
+    };
+
+    std::pmr::deque<std::pmr::string> words_;
+    std::pmr::vector<Node> nodes_;
+    size_t laid_out_node_count_ = 1;
+
+    static bool IsLabelLess(char lhs, char rhs) {
+        return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+    }
+
+    int FindNode(std::string_view word, int start = 0) const;
+    void Relayout();
+
+    static bool IsContinuationByte(char label) {
+        return (static_cast<unsigned char>(label) & 0xC0) == 0x80;
+    }
+
+    // A lead byte and the continuation bytes it announces; any other byte, including a stray
+    // continuation byte, is a code point of its own so that malformed input still splits deterministically
+    struct CodePoint {
+        uint32_t bytes = 0;
+        uint32_t size = 0;
+        uint32_t expected_size = 1;
+
+        void Append(char byte) {
+            if (size == 0) {
+                expected_size = GetExpectedSize(byte);
+            }
+            bytes = bytes << 8 | static_cast<unsigned char>(byte);
+            ++size;
+        }
+
+        bool IsComplete() const {
+            return size == expected_size;
+        }
+
+        bool operator==(const CodePoint& other) const = default;
+
+        static uint32_t GetExpectedSize(char lead) {
+            const auto byte = static_cast<unsigned char>(lead);
+            if (byte < 0xC0 || byte >= 0xF8) {
+                return 1;
+            }
+            return byte < 0xE0 ? 2 : byte < 0xF0 ? 3 : 4;
+        }
+    };
+
+    class FuzzyWord {
+    public:
+        FuzzyWord(std::string_view word, int max_edits, size_t max_steps)
+            : max_edits(max_edits), remaining_steps(max_steps), word_(word) {
+            for (size_t i = 0; i < word.size(); ++i) {
+                if (code_points_.empty() || code_points_.back().IsComplete() || !IsContinuationByte(word[i])) {
+                    has_stray_continuation_ |= IsContinuationByte(word[i]);
+                    code_points_.emplace_back();
+                    offsets_.push_back(i);
+                }
+                code_points_.back().Append(word[i]);
+            }
+            offsets_.push_back(word.size());
+        }
+
+        size_t size() const {
+            return code_points_.size();
+        }
+
+        CodePoint GetCodePoint(size_t index) const {
+            return code_points_[index];
+        }
+
+        std::string_view GetSuffix(size_t index) const {
+            return word_.substr(offsets_[index]);
+        }
+
+        // Such a suffix could merge with the trie's last code point, so it cannot be looked up as is
+        bool HasStrayContinuation() const {
+            return has_stray_continuation_;
+        }
+
+        const int max_edits;
+        size_t remaining_steps;
+        bool is_cut = false;
+
+        bool TakeSteps(size_t count) {
+            if (count > remaining_steps) {
+                remaining_steps = 0;
+                is_cut = true;
+                return false;
+            }
+            remaining_steps -= count;
+            return true;
+        }
+
+    private:
+        std::string_view word_;
+        std::vector<CodePoint> code_points_;
+        std::vector<size_t> offsets_;
+        bool has_stray_continuation_ = false;
+    };
+
+    // The walk advances one code point per DP row: VisitCodePoint follows continuation bytes
+    // below a lead byte and VisitRow scores each complete code point it reaches
+    template <typename Visitor>
+    bool VisitWithinDistance(int node, FuzzyWord& word, std::vector<int>& rows, size_t depth,
+        bool extends_code_point, Visitor& visitor) const;
+    template <typename Visitor>
+    bool VisitCodePoint(int node, FuzzyWord& word, std::vector<int>& rows, size_t depth,
+        CodePoint code_point, Visitor& visitor) const;
+    template <typename Visitor>
+    bool VisitRow(int node, FuzzyWord& word, std::vector<int>& rows, size_t depth,
+        CodePoint code_point, Visitor& visitor) const;
+};
+
+template <typename Visitor>
+void TermDictionary::ForEachWithPrefix(std::string_view prefix, Visitor visitor) const {
+    const int start = FindNode(prefix);
+    if (start == NO_NODE) {
+        return;
+    }
+    std::vector<int> queue = { start };
+    for (size_t position = 0; position < queue.size(); ++position) {
+        const Node& node = nodes_[queue[position]];
+        if (node.term_id != NO_TERM && !visitor(node.term_id)) {
+            return;
+        }
+        for (int child = node.first_child; child != NO_NODE; child = nodes_[child].next_sibling) {
+            queue.push_back(child);
+        }
+    }
+}
+
+template <typename Visitor>
+bool TermDictionary::ForEachWithinDistance(std::string_view word, int max_edits, Visitor visitor, size_t max_steps) const {
+    FuzzyWord fuzzy_word(word, max_edits, max_steps);
+    const size_t row_size = fuzzy_word.size() + 1;
+    std::vector<int> rows(row_size * (fuzzy_word.size() + max_edits + 1));
+    std::iota(rows.begin(), rows.begin() + row_size, 0);
+    const int root_distance = static_cast<int>(fuzzy_word.size());
+    if (nodes_[0].term_id != NO_TERM && root_distance <= max_edits && !visitor(nodes_[0].term_id, root_distance)) {
+        return true;
+    }
+    VisitWithinDistance(0, fuzzy_word, rows, 0, false, visitor);
+    return !fuzzy_word.is_cut;
+}
+
+template <typename Visitor>
+bool TermDictionary::VisitWithinDistance(int node, FuzzyWord& word, std::vector<int>& rows, size_t depth,
+    bool extends_code_point, Visitor& visitor) const {
+    for (int child = nodes_[node].first_child; child != NO_NODE; child = nodes_[child].next_sibling) {
+        // Such children complete the code point that ends at node, VisitCodePoint has been there
+        if (extends_code_point && IsContinuationByte(nodes_[child].label)) {
+            continue;
+        }
+        if (!VisitCodePoint(child, word, rows, depth, {}, visitor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+bool TermDictionary::VisitCodePoint(int node, FuzzyWord& word, std::vector<int>& rows, size_t depth,
+    CodePoint code_point, Visitor& visitor) const {
+    code_point.Append(nodes_[node].label);
+    if (!VisitRow(node, word, rows, depth, code_point, visitor)) {
+        return false;
+    }
+    if (code_point.IsComplete()) {
+        return true;
+    }
+    for (int child = nodes_[node].first_child; child != NO_NODE; child = nodes_[child].next_sibling) {
+        if (IsContinuationByte(nodes_[child].label)
+            && !VisitCodePoint(child, word, rows, depth, code_point, visitor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+bool TermDictionary::VisitRow(int node, FuzzyWord& word, std::vector<int>& rows, size_t depth,
+    CodePoint code_point, Visitor& visitor) const {
+    const int max_edits = word.max_edits;
+    const size_t row_size = word.size() + 1;
+    if ((depth + 2) * row_size > rows.size()) {
+        return true;
+    }
+    if (!word.TakeSteps(1)) {
+        return false;
+    }
+    const int* previous = rows.data() + depth * row_size;
+    int* current = rows.data() + (depth + 1) * row_size;
+    // Cells further than max_edits from the diagonal can never come back under the limit
+    const size_t band_first = depth + 1 > static_cast<size_t>(max_edits) ? depth + 1 - max_edits : 1;
+    const size_t band_last = std::min(row_size - 1, depth + 1 + max_edits);
+    // For an empty word the band is empty, but column zero still holds the distance
+    if (band_first > band_last + 1) {
+        return true;
+    }
+    current[band_first - 1] = band_first == 1 ? static_cast<int>(depth) + 1 : max_edits + 1;
+    if (band_last + 1 < row_size) {
+        current[band_last + 1] = max_edits + 1;
+    }
+    int row_min = current[band_first - 1];
+    for (size_t i = band_first; i <= band_last; ++i) {
+        current[i] = std::min({ previous[i] + 1, current[i - 1] + 1,
+            previous[i - 1] + (word.GetCodePoint(i - 1) == code_point ? 0 : 1) });
+        row_min = std::min(row_min, current[i]);
+    }
+    if (row_min > max_edits) {
+        return true;
+    }
+    if (row_min == max_edits && !word.HasStrayContinuation()) {
+        for (size_t i = band_first - 1; i <= band_last; ++i) {
+            if (current[i] != max_edits) {
+                continue;
+            }
+            const std::string_view suffix = word.GetSuffix(i);
+            if (!word.TakeSteps(suffix.size())) {
+                return false;
+            }
+            const int match = FindNode(suffix, node);
+            if (match != NO_NODE && nodes_[match].term_id != NO_TERM && !visitor(nodes_[match].term_id, max_edits)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (nodes_[node].term_id != NO_TERM && band_last == row_size - 1 && current[band_last] <= max_edits
+        && !visitor(nodes_[node].term_id, current[band_last])) {
+        return false;
+    }
+    return VisitWithinDistance(node, word, rows, depth + 1, !code_point.IsComplete(), visitor);
+}
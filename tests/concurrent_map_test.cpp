@@ -0,0 +1,157 @@
+#include "test_suites.h"
+
+#include <algorithm>
+#include <atomic>
+#include <execution>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_map.h"
+
+using namespace std;
+
+namespace {
+
+const int THREAD_COUNT = 8;
+const int KEY_COUNT = 1000;
+
+// Every key probes from the same slot, so lookups have to walk past tombstones
+struct CollidingHash {
+    size_t operator()(int) const {
+        return 0;
+    }
+};
+
+template <typename Function>
+void RunThreads(Function function) {
+    vector<jthread> threads;
+    for (int thread = 0; thread < THREAD_COUNT; ++thread) {
+        threads.emplace_back(function, thread);
+    }
+}
+
+void TestConcurrentAddAndErase() {
+    ConcurrentMap<int, long long> concurrent_map(4);
+    RunThreads([&concurrent_map](int thread) {
+        for (int round = 0; round < 10; ++round) {
+            for (int key = 0; key < KEY_COUNT; ++key) {
+                concurrent_map.Add(key, thread + 1);
+            }
+        }
+    });
+    ASSERT_EQUAL(concurrent_map.size(), static_cast<size_t>(KEY_COUNT));
+    const long long expected = 10LL * THREAD_COUNT * (THREAD_COUNT + 1) / 2;
+    for (const auto& [key, value] : concurrent_map.BuildOrdinaryMap()) {
+        ASSERT_EQUAL_HINT(value, expected, to_string(key));
+    }
+
+    // Threads erase overlapping ranges while others keep adding to the odd keys
+    atomic<size_t> erased = 0;
+    RunThreads([&](int thread) {
+        if (thread % 2 == 0) {
+            for (int key = 0; key < KEY_COUNT; key += 2) {
+                erased += concurrent_map.erase(key);
+            }
+        }
+        else {
+            for (int key = 1; key < KEY_COUNT; key += 2) {
+                concurrent_map.Add(key, 1);
+            }
+        }
+    });
+    ASSERT_EQUAL(erased.load(), static_cast<size_t>(KEY_COUNT / 2));
+    const map<int, long long> result = concurrent_map.BuildOrdinaryMap();
+    ASSERT_EQUAL(result.size(), static_cast<size_t>(KEY_COUNT / 2));
+    for (const auto& [key, value] : result) {
+        ASSERT_EQUAL_HINT(key % 2, 1, to_string(key));
+        ASSERT_EQUAL_HINT(value, expected + THREAD_COUNT / 2, to_string(key));
+    }
+}
+
+void TestTombstonesAreReused() {
+    ConcurrentMap<int, int, CollidingHash> concurrent_map(1);
+    for (int key = 0; key < 5; ++key) {
+        concurrent_map[key].ref_to_value = key * 10;
+    }
+    ASSERT_EQUAL(concurrent_map.erase(1), 1u);
+    ASSERT_EQUAL(concurrent_map.erase(1), 0u);
+    ASSERT_EQUAL(concurrent_map.erase(100), 0u);
+    // Key 4 sits behind the tombstone and must be found rather than inserted again
+    ASSERT_EQUAL(concurrent_map[4].ref_to_value, 40);
+    ASSERT_EQUAL(concurrent_map.size(), 4u);
+    concurrent_map[5].ref_to_value = 50;
+    ASSERT_EQUAL(concurrent_map.size(), 5u);
+    ASSERT((concurrent_map.BuildOrdinaryMap() == map<int, int>{ { 0, 0 }, { 2, 20 }, { 3, 30 }, { 4, 40 }, { 5, 50 } }));
+}
+
+void TestChurnRehashesTombstones() {
+    ConcurrentMap<int, int> concurrent_map(1);
+    concurrent_map.Add(-1, 7);
+    // Inserting and erasing fresh keys fills the table with tombstones until a rehash clears them
+    for (int key = 0; key < 100000; ++key) {
+        concurrent_map.Add(key, key);
+        ASSERT_EQUAL(concurrent_map.erase(key), 1u);
+    }
+    ASSERT_EQUAL(concurrent_map.size(), 1u);
+    ASSERT((concurrent_map.BuildOrdinaryMap() == map<int, int>{ { -1, 7 } }));
+
+    for (int key = 0; key < KEY_COUNT; ++key) {
+        concurrent_map.Add(key, key);
+    }
+    for (int key = 0; key < KEY_COUNT; key += 3) {
+        concurrent_map.erase(key);
+    }
+    const map<int, int> result = concurrent_map.BuildOrdinaryMap();
+    ASSERT_EQUAL(result.size(), static_cast<size_t>(1 + KEY_COUNT - (KEY_COUNT + 2) / 3));
+    for (const auto& [key, value] : result) {
+        if (key >= 0) {
+            ASSERT_HINT(key % 3 != 0, to_string(key));
+            ASSERT_EQUAL_HINT(value, key, to_string(key));
+        }
+    }
+}
+
+void TestExtractEmptiesMap() {
+    ConcurrentMap<int, int> concurrent_map(4);
+    for (int key = 0; key < KEY_COUNT; ++key) {
+        concurrent_map.Add(key, key + 1);
+    }
+    vector<pair<int, int>> extracted = concurrent_map.Extract();
+    sort(extracted.begin(), extracted.end());
+    ASSERT_EQUAL(extracted.size(), static_cast<size_t>(KEY_COUNT));
+    for (int key = 0; key < KEY_COUNT; ++key) {
+        ASSERT_EQUAL(extracted[key].first, key);
+        ASSERT_EQUAL(extracted[key].second, key + 1);
+    }
+    ASSERT_EQUAL(concurrent_map.size(), 0u);
+    ASSERT(concurrent_map.Extract().empty());
+    concurrent_map.Add(3, 1);
+    ASSERT_EQUAL(concurrent_map[3].ref_to_value, 1);
+}
+
+void TestParallelForEachVisitsEveryEntry() {
+    ConcurrentMap<int, int> concurrent_map(16);
+    for (int key = 0; key < KEY_COUNT * 10; ++key) {
+        concurrent_map.Add(key, 1);
+    }
+    atomic<long long> key_sum = 0;
+    atomic<int> value_sum = 0;
+    concurrent_map.ForEach(execution::par, [&](const int& key, const int& value) {
+        key_sum += key;
+        value_sum += value;
+    });
+    ASSERT_EQUAL(value_sum.load(), KEY_COUNT * 10);
+    ASSERT_EQUAL(key_sum.load(), 10LL * KEY_COUNT * (10LL * KEY_COUNT - 1) / 2);
+}
+
+}  // namespace
+
+void TestConcurrentMap(TestRunner& runner) {
+    RUN_TEST(runner, TestConcurrentAddAndErase);
+    RUN_TEST(runner, TestTombstonesAreReused);
+    RUN_TEST(runner, TestChurnRehashesTombstones);
+    RUN_TEST(runner, TestExtractEmptiesMap);
+    RUN_TEST(runner, TestParallelForEachVisitsEveryEntry);
+}
@@ -0,0 +1,139 @@
+#include "test_suites.h"
+
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "document_loader.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on"s;
+
+map<string, double> ToMap(const WordFrequencies& word_frequencies) {
+    map<string, double> result;
+    for (const auto [word, frequency] : word_frequencies) {
+        result.emplace(word, frequency);
+    }
+    return result;
+}
+
+string LoadError(SearchServer& search_server, const string& text, const LoaderOptions& options) {
+    istringstream input(text);
+    try {
+        LoadDocuments(search_server, input, options);
+    }
+    catch (const invalid_argument& e) {
+        return e.what();
+    }
+    return {};
+}
+
+LoaderOptions SmallBatches() {
+    LoaderOptions options;
+    options.batch_bytes = 64;
+    options.worker_count = 4;
+    options.max_batches_in_flight = 3;
+    return options;
+}
+
+void TestParallelLoadMatchesSequentialAdds() {
+    mt19937 generator(3);
+    const vector<string> statuses = { "ACTUAL"s, "IRRELEVANT"s, "BANNED"s, "3"s };
+    SearchServer expected(STOP_WORDS);
+    string file;
+    for (int i = 0; i < 2000; ++i) {
+        const int id = (i * 7919) % 100'003;
+        const int status = uniform_int_distribution(0, 3)(generator);
+        const vector<int> ratings = { uniform_int_distribution(-10, 10)(generator), uniform_int_distribution(-10, 10)(generator) };
+        string text;
+        for (int j = uniform_int_distribution(1, 10)(generator); j > 0; --j) {
+            text += "w"s + to_string(uniform_int_distribution(0, 300)(generator)) + (j % 4 == 0 ? " in "s : " "s);
+        }
+        expected.AddDocument(id, text, static_cast<DocumentStatus>(status), ratings);
+        file += to_string(id) + '\t' + statuses[status] + '\t' + to_string(ratings[0]) + ' ' + to_string(ratings[1]) + '\t'
+            + text + (i % 5 == 0 ? "\r\n"s : "\n"s);
+        if (i % 11 == 0) {
+            file += "\n"s;
+        }
+    }
+
+    SearchServer loaded(STOP_WORDS);
+    vector<size_t> progress;
+    LoaderOptions options = SmallBatches();
+    options.progress_interval = 100;
+    options.on_progress = [&progress](const LoadStats& stats) {
+        progress.push_back(stats.documents);
+    };
+    istringstream input(file);
+    const LoadStats stats = LoadDocuments(loaded, input, options);
+    ASSERT_EQUAL(stats.documents, 2000u);
+    ASSERT_EQUAL(stats.bytes, file.size());
+    ASSERT_EQUAL(progress.size(), 20u);
+    ASSERT_EQUAL(progress.back(), 2000u);
+    ASSERT_EQUAL(loaded.GetDocumentCount(), expected.GetDocumentCount());
+    ASSERT(vector<int>(loaded.begin(), loaded.end()) == vector<int>(expected.begin(), expected.end()));
+
+    for (const int id : expected) {
+        ASSERT_HINT(ToMap(loaded.GetWordFrequencies(id)) == ToMap(expected.GetWordFrequencies(id)), to_string(id));
+    }
+    for (int q = 0; q < 100; ++q) {
+        const string query = "w"s + to_string(q) + " w"s + to_string(q * 3) + " -w"s + to_string(q + 200);
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::REMOVED }) {
+            ASSERT_SAME_RANKING_HINT(expected.FindTopDocuments(query, status), loaded.FindTopDocuments(query, status), query);
+        }
+    }
+}
+
+void TestErrorsReportFileLineNumbers() {
+    // Blank and CRLF lines still count; the bad line lands in a later batch than the first documents
+    const string text = "1\tACTUAL\t1 2\tfirst cat\r\n"s
+        "\n"s
+        "2\tBANNED\t\tsecond dog\n"s
+        "\r\n"s
+        "3\t2\t-4\tthird bird with a rather long text to fill the batch\n"s
+        "4\tACTUAL\t5\n"s
+        "5\tACTUAL\t5\tnever indexed\n"s;
+    for (const LoaderOptions& options : { LoaderOptions{}, SmallBatches() }) {
+        SearchServer search_server(STOP_WORDS);
+        ASSERT_EQUAL(LoadError(search_server, text, options), "Line 6: Expected id, status, ratings and text separated by tabs"s);
+        ASSERT(vector<int>(search_server.begin(), search_server.end()) == vector<int>({ 1, 2, 3 }));
+    }
+
+    SearchServer search_server(STOP_WORDS);
+    ASSERT_EQUAL(LoadError(search_server, "1\tACTUAL\t1\tcat\n2\tFROZEN\t1\tdog\n"s, SmallBatches()),
+        "Line 2: Invalid document status 'FROZEN'"s);
+    ASSERT_EQUAL(LoadError(search_server, "7\tACTUAL\t1 x\tcat\n"s, SmallBatches()), "Line 1: Invalid rating 'x'"s);
+    ASSERT_EQUAL(LoadError(search_server, "-7\tACTUAL\t1\tcat\n"s, SmallBatches()).substr(0, 8), "Line 1: "s);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1);
+}
+
+void TestDuplicateIdReportsLaterLine() {
+    string text;
+    for (int id = 0; id < 50; ++id) {
+        text += to_string(id) + "\tACTUAL\t1\tword"s + to_string(id) + "\n"s;
+    }
+    text += "\n17\tACTUAL\t1\tduplicate\n"s;
+    text += "60\tACTUAL\t1\tafter\n"s;
+    for (const LoaderOptions& options : { LoaderOptions{}, SmallBatches() }) {
+        SearchServer search_server(STOP_WORDS);
+        const string error = LoadError(search_server, text, options);
+        ASSERT_EQUAL(error.substr(0, 9), "Line 52: "s);
+        ASSERT_EQUAL(search_server.GetDocumentCount(), 50);
+        ASSERT(search_server.FindTopDocuments("duplicate after"s).empty());
+    }
+}
+
+}  // namespace
+
+void TestDocumentLoader(TestRunner& runner) {
+    RUN_TEST(runner, TestParallelLoadMatchesSequentialAdds);
+    RUN_TEST(runner, TestErrorsReportFileLineNumbers);
+    RUN_TEST(runner, TestDuplicateIdReportsLaterLine);
+}
@@ -0,0 +1,93 @@
+#include "test_suites.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "document_table.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+void TestRemovedSlotsAreReused() {
+    DocumentTable table;
+    ASSERT_EQUAL(table.Add(10, DocumentStatus::ACTUAL, 1, 3), 0u);
+    ASSERT_EQUAL(table.Add(20, DocumentStatus::BANNED, 2, 4), 1u);
+    ASSERT_EQUAL(table.Add(30, DocumentStatus::ACTUAL, 3, 5), 2u);
+    table.Remove(table.GetSlot(20));
+    ASSERT(!table.IsAlive(1));
+    ASSERT_EQUAL(table.Find(20), DocumentTable::NO_SLOT);
+    ASSERT_THROWS(table.GetSlot(20), out_of_range);
+    ASSERT_EQUAL(table.size(), 2u);
+
+    // The freed slot takes the new document with all of its columns overwritten
+    ASSERT_EQUAL(table.Add(5, DocumentStatus::IRRELEVANT, 7, 9), 1u);
+    ASSERT(table.IsAlive(1));
+    ASSERT_EQUAL(table.GetId(1), 5);
+    ASSERT(table.GetStatus(1) == DocumentStatus::IRRELEVANT);
+    ASSERT_EQUAL(table.GetRating(1), 7);
+    ASSERT_EQUAL(table.GetLength(1), 9);
+    ASSERT_EQUAL(table.GetSlot(5), 1u);
+    ASSERT_EQUAL(table.GetSlotCount(), 3u);
+    ASSERT_EQUAL(table.Add(40, DocumentStatus::ACTUAL, 0, 1), 3u);
+    ASSERT_EQUAL(table.GetSlotCount(), 4u);
+}
+
+void TestIterationIsSortedById() {
+    mt19937 generator(5);
+    vector<int> ids(2000);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = static_cast<int>(i) * 3 - 1000;
+    }
+    shuffle(ids.begin(), ids.end(), generator);
+    DocumentTable table;
+    set<int> expected;
+    for (const int id : ids) {
+        table.Add(id, DocumentStatus::ACTUAL, 0, 1);
+        expected.insert(id);
+    }
+    ASSERT(vector<int>(table.begin(), table.end()) == vector<int>(expected.begin(), expected.end()));
+
+    for (size_t i = 0; i < ids.size(); i += 3) {
+        table.Remove(table.GetSlot(ids[i]));
+        expected.erase(ids[i]);
+    }
+    for (int id = 10000; id < 10100; ++id) {
+        table.Add(id, DocumentStatus::ACTUAL, 0, 1);
+        expected.insert(id);
+    }
+    table.Add(-5000, DocumentStatus::ACTUAL, 0, 1);
+    expected.insert(-5000);
+    ASSERT(vector<int>(table.begin(), table.end()) == vector<int>(expected.begin(), expected.end()));
+
+    // Ascending adds and removing the largest id keep the order without a rebuild
+    table.Remove(table.GetSlot(10099));
+    expected.erase(10099);
+    table.Add(20000, DocumentStatus::ACTUAL, 0, 1);
+    expected.insert(20000);
+    ASSERT(vector<int>(table.begin(), table.end()) == vector<int>(expected.begin(), expected.end()));
+}
+
+void TestServerIteratesIdsInOrder() {
+    SearchServer search_server(""s);
+    for (const int id : { 7, 3, 11, 1, 5 }) {
+        search_server.AddDocument(id, "word"s + to_string(id), DocumentStatus::ACTUAL, { 1 });
+    }
+    search_server.RemoveDocument(3);
+    search_server.AddDocument(2, "word two"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == vector<int>({ 1, 2, 5, 7, 11 }));
+    ASSERT_EQUAL(get<0>(search_server.MatchDocument("two"s, 2)).size(), 1u);
+}
+
+}  // namespace
+
+void TestDocumentTable(TestRunner& runner) {
+    RUN_TEST(runner, TestRemovedSlotsAreReused);
+    RUN_TEST(runner, TestIterationIsSortedById);
+    RUN_TEST(runner, TestServerIteratesIdsInOrder);
+}
@@ -0,0 +1,20 @@
+#include "test_suites.h"
+
+using namespace std;
+
+int main() {
+    TestRunner runner;
+    TestShardedSearchServer(runner);
+    TestDocumentLoader(runner);
+    TestUpdateDocument(runner);
+    TestDocumentTable(runner);
+    TestTermDictionary(runner);
+    TestQueryLimits(runner);
+    TestMemoryBudget(runner);
+    TestConcurrentMap(runner);
+    if (runner.GetFailCount() > 0) {
+        cerr << runner.GetFailCount() << " tests failed"s << endl;
+        return 1;
+    }
+    return 0;
+}
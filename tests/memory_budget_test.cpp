@@ -0,0 +1,107 @@
+#include "test_suites.h"
+
+#include <memory_resource>
+#include <string>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+string MakeText(int id) {
+    return "common word"s + to_string(id) + " group"s + to_string(id % 37) + " tail"s + to_string(id % 5);
+}
+
+void AddDocuments(SearchServer& search_server, int first_id, int count) {
+    for (int id = first_id; id < first_id + count; ++id) {
+        search_server.AddDocument(id, MakeText(id), DocumentStatus::ACTUAL, { id % 10 });
+    }
+}
+
+void TestMemoryStatsTrackStructures() {
+    SearchServer search_server("and in"s);
+    const MemoryStats empty = search_server.GetMemoryStats();
+    ASSERT(empty.dictionary > 0);
+    ASSERT_EQUAL(empty.postings, 0u);
+    ASSERT_EQUAL(empty.forward_index, 0u);
+
+    AddDocuments(search_server, 0, 500);
+    const MemoryStats stats = search_server.GetMemoryStats();
+    ASSERT(stats.dictionary > empty.dictionary);
+    ASSERT(stats.postings > 0 && stats.forward_index > 0 && stats.documents > 0);
+    ASSERT_EQUAL(stats.GetTotal(), stats.dictionary + stats.postings + stats.forward_index + stats.documents);
+    ASSERT(stats.reserved >= stats.GetTotal());
+
+    // Without an own pool there is nothing between the counters and the caller's resource
+    pmr::synchronized_pool_resource resource;
+    SearchServer external("and in"s, SearchServerResources{ &resource, nullptr });
+    AddDocuments(external, 0, 500);
+    const MemoryStats external_stats = external.GetMemoryStats();
+    ASSERT_EQUAL(external_stats.reserved, external_stats.GetTotal());
+    ASSERT_EQUAL(external_stats.GetTotal(), stats.GetTotal());
+}
+
+void TestCompactReleasesMemory() {
+    SearchServer search_server(""s);
+    AddDocuments(search_server, 0, 2000);
+    const MemoryStats full = search_server.GetMemoryStats();
+    for (int id = 0; id < 1500; ++id) {
+        search_server.RemoveDocument(id);
+    }
+    const MemoryStats removed = search_server.GetMemoryStats();
+    ASSERT(removed.postings < full.postings);
+    search_server.Compact();
+    const MemoryStats compacted = search_server.GetMemoryStats();
+    ASSERT(compacted.postings < removed.postings);
+    ASSERT(compacted.forward_index < removed.forward_index);
+    ASSERT(compacted.GetTotal() < full.GetTotal() / 2);
+    ASSERT(compacted.reserved < removed.reserved);
+    ASSERT_EQUAL(search_server.FindTopDocuments("word1999"s).size(), 1u);
+    ASSERT(search_server.FindTopDocuments("word0"s).empty());
+}
+
+void TestBudgetRejectsAndRecovers() {
+    SearchServer search_server(""s);
+    AddDocuments(search_server, 0, 2000);
+    const size_t total = search_server.GetMemoryStats().GetTotal();
+    search_server.SetMemoryBudget(total * 8 / 10);
+    ASSERT_EQUAL(search_server.GetMemoryBudget(), total * 8 / 10);
+    ASSERT_THROWS(search_server.AddDocument(5000, "new"s, DocumentStatus::ACTUAL, { 1 }), MemoryBudgetExceeded);
+    ASSERT_THROWS(search_server.UpdateDocument(7, "changed"s, DocumentStatus::ACTUAL, { 1 }), MemoryBudgetExceeded);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2000);
+
+    for (int id = 0; id < 1500; ++id) {
+        search_server.RemoveDocument(id);
+    }
+    AddDocuments(search_server, 5000, 100);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 600);
+
+    search_server.SetMemoryBudget(0);
+    AddDocuments(search_server, 10000, 100);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 700);
+}
+
+// Freed posting nodes stay reserved by the pool, so a budget below the reserved bytes must still admit documents
+void TestBudgetIgnoresPoolReservations() {
+    SearchServer search_server(""s);
+    AddDocuments(search_server, 0, 2000);
+    search_server.SetMemoryBudget(search_server.GetMemoryStats().reserved * 8 / 10);
+    for (int id = 0; id < 1500; ++id) {
+        search_server.RemoveDocument(id);
+    }
+    search_server.Compact();
+    const MemoryStats stats = search_server.GetMemoryStats();
+    ASSERT(stats.GetTotal() < search_server.GetMemoryBudget());
+    AddDocuments(search_server, 5000, 500);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1000);
+}
+
+}  // namespace
+
+void TestMemoryBudget(TestRunner& runner) {
+    RUN_TEST(runner, TestMemoryStatsTrackStructures);
+    RUN_TEST(runner, TestCompactReleasesMemory);
+    RUN_TEST(runner, TestBudgetRejectsAndRecovers);
+    RUN_TEST(runner, TestBudgetIgnoresPoolReservations);
+}
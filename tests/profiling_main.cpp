@@ -0,0 +1,13 @@
+#include "test_suites.h"
+
+using namespace std;
+
+int main() {
+    TestRunner runner;
+    TestQueryProfile(runner);
+    if (runner.GetFailCount() > 0) {
+        cerr << runner.GetFailCount() << " tests failed"s << endl;
+        return 1;
+    }
+    return 0;
+}
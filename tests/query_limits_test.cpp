@@ -0,0 +1,154 @@
+#include "test_suites.h"
+
+#include <chrono>
+#include <execution>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "local_executor.h"
+#include "process_queries.h"
+#include "search_server.h"
+#include "task.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = static_cast<int>(POSTING_BLOCK_SIZE) * 10;
+
+// Every document has "common", even ones also "even", and every tenth one "rare"
+SearchServer MakeServer() {
+    SearchServer search_server("and"s);
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        string text = "common word"s + to_string(id % 100);
+        if (id % 2 == 0) {
+            text += " even"s;
+        }
+        if (id % 10 == 0) {
+            text += " rare"s;
+        }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 7 });
+    }
+    return search_server;
+}
+
+const auto IS_ACTUAL = [](int, DocumentStatus status, int) {
+    return status == DocumentStatus::ACTUAL;
+};
+
+const vector<string> QUERIES = { "common"s, "rare word7"s, "word3 -even"s, "common rare -word10"s, "missing"s };
+
+void TestNoLimitsKeepResults() {
+    const SearchServer search_server = MakeServer();
+    for (const string& query : QUERIES) {
+        const auto expected = search_server.FindTopDocuments(query);
+        const SearchResult sequential = search_server.FindTopDocuments(execution::seq, query, IS_ACTUAL, QueryLimits{});
+        const SearchResult parallel = search_server.FindTopDocuments(execution::par, query, IS_ACTUAL, QueryLimits{});
+        ASSERT_HINT(sequential.is_complete && parallel.is_complete, query);
+        ASSERT_SAME_RANKING_HINT(expected, sequential.documents, query);
+        ASSERT_SAME_RANKING_HINT(expected, parallel.documents, query);
+    }
+}
+
+void TestPassedDeadlineStopsScan() {
+    const SearchServer search_server = MakeServer();
+    QueryLimits limits;
+    limits.deadline = chrono::steady_clock::now() - 1s;
+    for (const SearchResult& result : { search_server.FindTopDocuments(execution::seq, "common rare"s, IS_ACTUAL, limits),
+             search_server.FindTopDocuments(execution::par, "common rare"s, IS_ACTUAL, limits) })
+    {
+        ASSERT(!result.is_complete);
+        ASSERT(result.documents.empty());
+    }
+}
+
+void TestStopRequestStopsScan() {
+    const SearchServer search_server = MakeServer();
+    stop_source stop_source;
+    stop_source.request_stop();
+    const QueryLimits limits{ chrono::steady_clock::time_point::max(), stop_source.get_token() };
+    ASSERT(!search_server.FindTopDocuments(execution::seq, "common"s, IS_ACTUAL, limits).is_complete);
+    ASSERT(!search_server.FindTopDocuments(execution::par, "common"s, IS_ACTUAL, limits).is_complete);
+}
+
+void TestStopDuringScanKeepsMinusWords() {
+    const SearchServer search_server = MakeServer();
+    stop_source stop_source;
+    const QueryLimits limits{ chrono::steady_clock::time_point::max(), stop_source.get_token() };
+    size_t checked = 0;
+    const auto stop_midway = [&](int, DocumentStatus status, int) {
+        if (++checked == POSTING_BLOCK_SIZE + POSTING_BLOCK_SIZE / 2) {
+            stop_source.request_stop();
+        }
+        return status == DocumentStatus::ACTUAL;
+    };
+    const SearchResult result = search_server.FindTopDocuments(execution::seq, "common -even"s, stop_midway, limits);
+    // The limits are polled once per block, so the scan ends at the first block boundary after the request
+    ASSERT_EQUAL(checked, 2 * POSTING_BLOCK_SIZE);
+    ASSERT(!result.is_complete);
+    ASSERT(!result.documents.empty());
+    for (const Document& document : result.documents) {
+        ASSERT_EQUAL(document.id % 2, 1);
+    }
+}
+
+void TestAsyncSearchHonorsLimits() {
+    const SearchServer search_server = MakeServer();
+    LocalExecutor executor(2);
+    for (const string& query : QUERIES) {
+        const SearchResult result = SyncWait(search_server.FindTopDocumentsAsync(executor, query));
+        ASSERT_HINT(result.is_complete, query);
+        ASSERT_SAME_RANKING_HINT(search_server.FindTopDocuments(query), result.documents, query);
+    }
+    stop_source stop_source;
+    stop_source.request_stop();
+    const SearchResult stopped = SyncWait(search_server.FindTopDocumentsAsync(executor, "common"s, DocumentStatus::ACTUAL,
+        QueryLimits{ chrono::steady_clock::time_point::max(), stop_source.get_token() }));
+    ASSERT(!stopped.is_complete);
+}
+
+Task<int> ResumeOn(LocalExecutor& executor, int value) {
+    co_await executor.Schedule();
+    co_return value;
+}
+
+// The waiter returns right after the executor thread wakes it, so each wait races that thread's release
+void TestSyncWaitFromExecutorThreads() {
+    LocalExecutor executor(4);
+    long long sum = 0;
+    for (int i = 0; i < 20000; ++i) {
+        sum += SyncWait(ResumeOn(executor, i));
+    }
+    ASSERT_EQUAL(sum, 20000LL * 19999 / 2);
+}
+
+void TestProcessQueriesWithTimeout() {
+    const SearchServer search_server = MakeServer();
+    const auto expected = ProcessQueries(search_server, QUERIES);
+    const auto results = ProcessQueries(search_server, QUERIES, 1h);
+    ASSERT_EQUAL(results.size(), QUERIES.size());
+    for (size_t i = 0; i < QUERIES.size(); ++i) {
+        ASSERT_HINT(results[i].is_complete, QUERIES[i]);
+        ASSERT_SAME_RANKING_HINT(expected[i], results[i].documents, QUERIES[i]);
+    }
+
+    // With no time at all every query that reaches the index stops before its first word
+    const auto timed_out = ProcessQueries(search_server, QUERIES, chrono::steady_clock::duration::zero());
+    for (size_t i = 0; i + 1 < QUERIES.size(); ++i) {
+        ASSERT_HINT(!timed_out[i].is_complete, QUERIES[i]);
+    }
+    ASSERT(timed_out.back().is_complete && timed_out.back().documents.empty());
+}
+
+}  // namespace
+
+void TestQueryLimits(TestRunner& runner) {
+    RUN_TEST(runner, TestNoLimitsKeepResults);
+    RUN_TEST(runner, TestPassedDeadlineStopsScan);
+    RUN_TEST(runner, TestStopRequestStopsScan);
+    RUN_TEST(runner, TestStopDuringScanKeepsMinusWords);
+    RUN_TEST(runner, TestAsyncSearchHonorsLimits);
+    RUN_TEST(runner, TestSyncWaitFromExecutorThreads);
+    RUN_TEST(runner, TestProcessQueriesWithTimeout);
+}
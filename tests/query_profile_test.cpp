@@ -0,0 +1,144 @@
+#include "test_suites.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <sstream>
+#include <string>
+
+#include "query_profile.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+static_assert(QUERY_PROFILING_ENABLED, "search_server_profiling_tests must link the profiled core");
+
+const int DOCUMENT_COUNT = 100;
+
+void TestHistogramBucketBounds() {
+    for (uint64_t value = 0; value < 4; ++value) {
+        ASSERT_EQUAL(Histogram::GetBucket(value), value);
+        ASSERT_EQUAL(Histogram::GetBucketUpperBound(value), value);
+    }
+    ASSERT_EQUAL(Histogram::GetBucket(UINT64_MAX), Histogram::BUCKET_COUNT - 1);
+    ASSERT_EQUAL(Histogram::GetBucketUpperBound(Histogram::BUCKET_COUNT - 1), UINT64_MAX);
+    // Buckets tile the value range with no gaps
+    for (size_t bucket = 0; bucket + 1 < Histogram::BUCKET_COUNT; ++bucket) {
+        const uint64_t upper = Histogram::GetBucketUpperBound(bucket);
+        ASSERT_EQUAL_HINT(Histogram::GetBucket(upper), bucket, to_string(bucket));
+        ASSERT_EQUAL_HINT(Histogram::GetBucket(upper + 1), bucket + 1, to_string(bucket));
+    }
+    for (uint64_t value = 1; value < (uint64_t{ 1 } << 40); value = value * 3 + 1) {
+        const uint64_t upper = Histogram::GetBucketUpperBound(Histogram::GetBucket(value));
+        ASSERT_HINT(upper >= value && (upper - value) * 4 <= value, to_string(value));
+    }
+}
+
+void TestHistogramPercentiles() {
+    Histogram empty;
+    ASSERT_EQUAL(empty.GetPercentile(0.5), 0u);
+    ASSERT_EQUAL(empty.GetMean(), 0.0);
+
+    Histogram lower;
+    Histogram upper;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        (value <= 500 ? lower : upper).Add(value);
+    }
+    Histogram all = lower;
+    all.Merge(upper);
+    ASSERT_EQUAL(all.GetCount(), 1000u);
+    ASSERT_EQUAL(all.GetSum(), 500500u);
+    ASSERT_EQUAL(all.GetMax(), 1000u);
+    ASSERT_EQUAL(all.GetMean(), 500.5);
+
+    Histogram sequential;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        sequential.Add(value);
+    }
+    ASSERT(all.GetBuckets() == sequential.GetBuckets());
+
+    const uint64_t p50 = all.GetPercentile(0.5);
+    ASSERT(p50 >= 501 && p50 * 4 <= 501 * 5);
+    const uint64_t p90 = all.GetPercentile(0.9);
+    ASSERT(p90 >= 901 && p90 * 4 <= 901 * 5);
+    // The top bucket reaches 1023, but no percentile may report more than the largest value seen
+    ASSERT_EQUAL(all.GetPercentile(0.99), 1000u);
+    ASSERT_EQUAL(all.GetPercentile(1.0), 1000u);
+}
+
+SearchServer MakeServer() {
+    SearchServer search_server("and"s);
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        search_server.AddDocument(id, id % 2 == 0 ? "alpha beta"s : "alpha gamma"s, DocumentStatus::ACTUAL, { id });
+    }
+    return search_server;
+}
+
+void TestQueriesFillSnapshot() {
+    const SearchServer search_server = MakeServer();
+    ResetQueryProfile();
+    ASSERT_EQUAL(TakeQueryProfileSnapshot().GetQueryCount(), 0u);
+    search_server.FindTopDocuments(execution::seq, "alpha beta"s);
+    search_server.FindTopDocuments(execution::par, "alpha beta"s);
+    search_server.FindTopDocuments(execution::seq, "gamma -beta"s);
+
+    const QueryProfileSnapshot snapshot = TakeQueryProfileSnapshot();
+    ASSERT_EQUAL(snapshot.GetQueryCount(), 3u);
+    for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage) {
+        ASSERT_EQUAL_HINT(snapshot.stage_ns[stage].GetCount(), 3u, GetQueryStageName(static_cast<QueryStage>(stage)));
+    }
+    ASSERT(snapshot.stage_ns[static_cast<size_t>(QueryStage::POSTING_SCAN)].GetSum() > 0);
+    const Histogram& scanned = snapshot.counters[static_cast<size_t>(QueryCounter::POSTINGS_SCANNED)];
+    ASSERT_EQUAL(scanned.GetSum(), static_cast<uint64_t>(DOCUMENT_COUNT * 3 + DOCUMENT_COUNT / 2));
+    ASSERT_EQUAL(scanned.GetMax(), static_cast<uint64_t>(DOCUMENT_COUNT * 3 / 2));
+    const Histogram& scored = snapshot.counters[static_cast<size_t>(QueryCounter::DOCUMENTS_SCORED)];
+    ASSERT_EQUAL(scored.GetSum(), static_cast<uint64_t>(DOCUMENT_COUNT * 2 + DOCUMENT_COUNT / 2));
+
+    ResetQueryProfile();
+    ASSERT_EQUAL(TakeQueryProfileSnapshot().GetQueryCount(), 0u);
+}
+
+void TestSnapshotJson() {
+    QueryProfileSnapshot snapshot;
+    snapshot.stage_ns[static_cast<size_t>(QueryStage::PARSE)].Add(100);
+    snapshot.stage_ns[static_cast<size_t>(QueryStage::PARSE)].Add(300);
+    snapshot.counters[static_cast<size_t>(QueryCounter::POSTINGS_SCANNED)].Add(7);
+    ostringstream out;
+    snapshot.PrintJson(out);
+    const string json = out.str();
+
+    ASSERT(json.find("\"queries\": 2"s) != string::npos);
+    ASSERT(json.find("\"parse\": { \"count\": 2, \"sum\": 400, \"mean\": 200"s) != string::npos);
+    ASSERT(json.find("\"postings_scanned\": { \"count\": 1, \"sum\": 7"s) != string::npos);
+    ASSERT(json.find("\"buckets\": [[7, 1]]"s) != string::npos);
+    // Empty histograms still print every field, with an empty bucket list
+    ASSERT(json.find("\"top_k\": { \"count\": 0, \"sum\": 0, \"mean\": 0"s) != string::npos);
+    for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage) {
+        const string name = "\""s + GetQueryStageName(static_cast<QueryStage>(stage)) + "\": {"s;
+        ASSERT_HINT(json.find(name) != string::npos, name);
+    }
+    ASSERT(json.find("nan"s) == string::npos && json.find("inf"s) == string::npos);
+
+    int depth = 0;
+    for (const char c : json) {
+        if (c == '{' || c == '[') {
+            ++depth;
+        }
+        else if (c == '}' || c == ']') {
+            ASSERT(--depth >= 0);
+        }
+    }
+    ASSERT_EQUAL(depth, 0);
+    ASSERT_EQUAL(count(json.begin(), json.end(), '"') % 2, 0);
+}
+
+}  // namespace
+
+void TestQueryProfile(TestRunner& runner) {
+    RUN_TEST(runner, TestHistogramBucketBounds);
+    RUN_TEST(runner, TestHistogramPercentiles);
+    RUN_TEST(runner, TestQueriesFillSnapshot);
+    RUN_TEST(runner, TestSnapshotJson);
+}
@@ -0,0 +1,230 @@
+#include "test_suites.h"
+
+#include <execution>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "process_shard.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on"s;
+
+struct TestDocument {
+    int id;
+    string text;
+    DocumentStatus status;
+    vector<int> ratings;
+};
+
+vector<TestDocument> MakeDocuments(int count, int vocabulary_size, mt19937& generator) {
+    vector<TestDocument> documents;
+    for (int id = 0; id < count; ++id) {
+        string text;
+        const int word_count = uniform_int_distribution(1, 12)(generator);
+        for (int i = 0; i < word_count; ++i) {
+            text += "w"s + to_string(uniform_int_distribution(0, vocabulary_size - 1)(generator)) + (i % 5 == 0 ? " and "s : " "s);
+        }
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, 3)(generator));
+        documents.push_back({ id * 7 + 3, text, status, { uniform_int_distribution(-5, 10)(generator), 4 } });
+    }
+    return documents;
+}
+
+vector<string> MakeQueries(int count, int vocabulary_size, mt19937& generator) {
+    vector<string> queries;
+    for (int q = 0; q < count; ++q) {
+        string query;
+        for (int i = 0; i < 3; ++i) {
+            query += "w"s + to_string(uniform_int_distribution(0, vocabulary_size - 1)(generator)) + " "s;
+        }
+        if (q % 3 == 0) {
+            query += "-w"s + to_string(uniform_int_distribution(0, vocabulary_size - 1)(generator));
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+template <typename Server>
+void AddDocuments(Server& server, const vector<TestDocument>& documents) {
+    for (const TestDocument& document : documents) {
+        server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+}
+
+void AssertSameResults(const SearchServer& single, const ShardedSearchServer& sharded, const vector<string>& queries) {
+    for (const string& query : queries) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            ASSERT_SAME_RANKING_HINT(single.FindTopDocuments(query, status), sharded.FindTopDocuments(query, status), query);
+        }
+    }
+}
+
+void TestLocalShardsUseGlobalInverseDocumentFrequency() {
+    mt19937 generator(7);
+    const auto documents = MakeDocuments(600, 150, generator);
+    SearchServer single(STOP_WORDS);
+    ShardedSearchServer sharded(STOP_WORDS, 4);
+    AddDocuments(single, documents);
+    AddDocuments(sharded, documents);
+    ASSERT_EQUAL(sharded.GetDocumentCount(), single.GetDocumentCount());
+
+    const auto queries = MakeQueries(200, 150, generator);
+    AssertSameResults(single, sharded, queries);
+    for (const string& query : queries) {
+        ASSERT_SAME_RANKING_HINT(single.FindTopDocuments(query), sharded.FindTopDocuments(execution::par, query), query);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        single.RemoveDocument(documents[i * 3].id);
+        sharded.RemoveDocument(documents[i * 3].id);
+    }
+    AssertSameResults(single, sharded, queries);
+}
+
+void TestProcessShardProtocol() {
+    auto shard = ProcessShard::Spawn(STOP_WORDS);
+    shard->AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    shard->AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::BANNED, { 7, 2, 7 });
+    ASSERT_EQUAL(shard->GetDocumentCount(), 2);
+
+    const auto [words, status] = shard->MatchDocument("fluffy cat -collar"s, 2);
+    ASSERT(words == vector<string>({ "cat"s, "fluffy"s }));
+    ASSERT(status == DocumentStatus::BANNED);
+    ASSERT(get<0>(shard->MatchDocument("cat -collar"s, 1)).empty());
+
+    const TermStatistics statistics = shard->CollectTermStatistics("cat fluffy"s);
+    ASSERT_EQUAL(statistics.document_count, 2);
+    ASSERT_EQUAL(statistics.document_freqs.at("cat"s), 2);
+    ASSERT_EQUAL(statistics.document_freqs.at("fluffy"s), 1);
+
+    shard->UpdateDocument(1, "fluffy dog"s, DocumentStatus::ACTUAL, { 4 });
+    shard->SetStatus(2, DocumentStatus::ACTUAL);
+    shard->SetRating(2, 9);
+    const auto documents = shard->FindTopDocuments("fluffy"s, DocumentStatus::ACTUAL, shard->CollectTermStatistics("fluffy"s));
+    ASSERT_EQUAL(documents.size(), 2u);
+    ASSERT_EQUAL(documents[0].id, 2);
+    ASSERT_EQUAL(documents[0].rating, 9);
+    ASSERT_EQUAL(documents[1].id, 1);
+
+    // Errors raised in the child come back as the same exception types
+    ASSERT_THROWS(shard->AddDocument(1, "again"s, DocumentStatus::ACTUAL, {}), invalid_argument);
+    ASSERT_THROWS(shard->MatchDocument("cat"s, 42), out_of_range);
+    ASSERT_THROWS(shard->FindTopDocuments("cat -"s, DocumentStatus::ACTUAL, {}), invalid_argument);
+    ASSERT_THROWS(shard->FindTopDocuments("cat"s, DocumentFilter([](int, DocumentStatus, int) { return true; }), {}),
+        logic_error);
+
+    shard->RemoveDocument(1);
+    ASSERT_EQUAL(shard->GetDocumentCount(), 1);
+}
+
+void TestProcessShardsMatchSingleServer() {
+    mt19937 generator(11);
+    const auto documents = MakeDocuments(300, 80, generator);
+    vector<unique_ptr<SearchShard>> shards;
+    for (int i = 0; i < 3; ++i) {
+        shards.push_back(ProcessShard::Spawn(STOP_WORDS));
+    }
+    ShardedSearchServer sharded(move(shards));
+    SearchServer single(STOP_WORDS);
+    AddDocuments(single, documents);
+    AddDocuments(sharded, documents);
+
+    AssertSameResults(single, sharded, MakeQueries(100, 80, generator));
+    // Matched words of the single server are views into the query
+    const string query = "w1 w2 w3 w4 w5 -w6"s;
+    for (const TestDocument& document : documents) {
+        const auto [expected_words, expected_status] = single.MatchDocument(query, document.id);
+        const auto [words, status] = sharded.MatchDocument(query, document.id);
+        ASSERT(vector<string>(expected_words.begin(), expected_words.end()) == words);
+        ASSERT(expected_status == status);
+    }
+}
+
+// A shard child must not keep descriptors it inherited, such as the write end of this pipe
+void TestProcessShardClosesInheritedDescriptors() {
+    int pipe_fds[2];
+    ASSERT_EQUAL(pipe(pipe_fds), 0);
+    auto shard = ProcessShard::Spawn(STOP_WORDS);
+    ASSERT_EQUAL(shard->GetDocumentCount(), 0);
+    close(pipe_fds[1]);
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+    char byte = 0;
+    // End of file, rather than EAGAIN from a writer still open in the child
+    ASSERT_EQUAL(read(pipe_fds[0], &byte, 1), 0);
+    close(pipe_fds[0]);
+}
+
+void TestServeShardRejectsUnknownCommand() {
+    int socket_fds[2];
+    ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socket_fds), 0);
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    thread server([&] {
+        ServeShard(socket_fds[1], search_server);
+        close(socket_fds[1]);
+    });
+    {
+        // A message of one byte holding a command number no shard knows
+        const char request[] = { 1, 0, 0, 0, 100 };
+        ASSERT_EQUAL(write(socket_fds[0], request, sizeof(request)), static_cast<ssize_t>(sizeof(request)));
+        uint32_t size = 0;
+        ASSERT_EQUAL(read(socket_fds[0], &size, sizeof(size)), static_cast<ssize_t>(sizeof(size)));
+        string reply(size, '\0');
+        ASSERT_EQUAL(read(socket_fds[0], reply.data(), size), static_cast<ssize_t>(size));
+        ASSERT(!reply.empty() && reply[0] != 0);
+        ASSERT(reply.find("Unknown shard command 100"s) != string::npos);
+
+        // The connection stays usable after the error reply
+        ProcessShard shard(socket_fds[0]);
+        ASSERT_EQUAL(shard.GetDocumentCount(), 1);
+    }
+    server.join();
+}
+
+void TestBrokenShardFailsFast() {
+    int socket_fds[2];
+    ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socket_fds), 0);
+    // The peer reads the request, answers with half a reply and goes away
+    thread peer([fd = socket_fds[1]] {
+        char buffer[64];
+        [[maybe_unused]] const ssize_t received = read(fd, buffer, sizeof(buffer));
+        const char partial_reply[] = { 16, 0, 0, 0, 0 };
+        [[maybe_unused]] const ssize_t sent = write(fd, partial_reply, sizeof(partial_reply));
+        close(fd);
+    });
+    ProcessShard shard(socket_fds[0]);
+    ASSERT_THROWS(shard.GetDocumentCount(), runtime_error);
+    peer.join();
+    try {
+        shard.RemoveDocument(1);
+        ASSERT(false);
+    }
+    catch (const runtime_error& e) {
+        ASSERT_EQUAL(string(e.what()), "Shard connection is broken"s);
+    }
+}
+
+}  // namespace
+
+void TestShardedSearchServer(TestRunner& runner) {
+    RUN_TEST(runner, TestProcessShardProtocol);
+    RUN_TEST(runner, TestProcessShardsMatchSingleServer);
+    RUN_TEST(runner, TestProcessShardClosesInheritedDescriptors);
+    RUN_TEST(runner, TestLocalShardsUseGlobalInverseDocumentFrequency);
+    RUN_TEST(runner, TestServeShardRejectsUnknownCommand);
+    RUN_TEST(runner, TestBrokenShardFailsFast);
+}
@@ -0,0 +1,278 @@
+#include "test_suites.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "term_dictionary.h"
+
+using namespace std;
+
+namespace {
+
+// Splits like the trie walk: a lead byte takes the continuation bytes it announces, any other byte stands alone
+vector<string> SplitIntoCodePoints(string_view word) {
+    const auto expected_size = [](unsigned char lead) -> size_t {
+        return lead < 0xC0 || lead >= 0xF8 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    };
+    vector<string> code_points;
+    for (const char byte : word) {
+        if (code_points.empty() || code_points.back().size() == expected_size(code_points.back()[0])
+            || (static_cast<unsigned char>(byte) & 0xC0) != 0x80)
+        {
+            code_points.emplace_back();
+        }
+        code_points.back() += byte;
+    }
+    return code_points;
+}
+
+int ComputeLevenshteinDistance(string_view lhs, string_view rhs) {
+    const auto a = SplitIntoCodePoints(lhs);
+    const auto b = SplitIntoCodePoints(rhs);
+    vector<int> previous(b.size() + 1);
+    vector<int> current(b.size() + 1);
+    iota(previous.begin(), previous.end(), 0);
+    for (size_t i = 1; i <= a.size(); ++i) {
+        current[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= b.size(); ++j) {
+            current[j] = min({ previous[j] + 1, current[j - 1] + 1, previous[j - 1] + (a[i - 1] != b[j - 1]) });
+        }
+        swap(previous, current);
+    }
+    return previous[b.size()];
+}
+
+vector<string> MakeWords(TermDictionary& dictionary, int count, mt19937& generator) {
+    // Mostly ASCII and Cyrillic, with multi-byte symbols, stray continuation bytes and truncated lead bytes
+    const vector<string> alphabet = { "a"s, "b"s, "c"s, "к"s, "о"s, "т"s, "и"s, "ы"s, "€"s, "\x80"s, "\xD0"s };
+    vector<string> words;
+    for (int i = 0; i < count; ++i) {
+        string word;
+        for (int length = uniform_int_distribution(1, 6)(generator); length > 0; --length) {
+            const size_t r = uniform_int_distribution(0, 99)(generator);
+            word += r < 90 ? alphabet[r % 8] : alphabet[8 + r % 3];
+        }
+        if (i % 50 == 0) {
+            word += "\x80\x80\x80\x80"s;
+        }
+        if (i % 70 == 0) {
+            word = "\x80"s + word;
+        }
+        dictionary.Add(word);
+        words.push_back(word);
+    }
+    return words;
+}
+
+void TestFuzzyWalkMatchesBruteForce() {
+    mt19937 generator(5);
+    TermDictionary dictionary;
+    const auto words = MakeWords(dictionary, 5000, generator);
+    const vector<string> edits = { "a"s, "т"s, "€"s, "\x80"s, "\xD0"s };
+    for (int q = 0; q < 200; ++q) {
+        string query = words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)];
+        if (q % 3 == 0) {
+            query += edits[q % edits.size()];
+        }
+        if (q % 5 == 0) {
+            query = "\x80"s + query;
+        }
+        if (q % 7 == 0) {
+            query.erase(0, 1);
+        }
+        for (int max_edits = 0; max_edits <= 2; ++max_edits) {
+            vector<string> found;
+            const bool is_complete = dictionary.ForEachWithinDistance(query, max_edits, [&](int term_id, int distance) {
+                found.emplace_back(dictionary.GetWord(term_id));
+                ASSERT_EQUAL_HINT(distance, ComputeLevenshteinDistance(found.back(), query), query);
+                return true;
+            });
+            ASSERT(is_complete);
+            const set<string> unique_found(found.begin(), found.end());
+            ASSERT_EQUAL_HINT(unique_found.size(), found.size(), query);
+            set<string> expected;
+            for (size_t term_id = 0; term_id < dictionary.size(); ++term_id) {
+                const string_view word = dictionary.GetWord(static_cast<int>(term_id));
+                if (ComputeLevenshteinDistance(word, query) <= max_edits) {
+                    expected.emplace(word);
+                }
+            }
+            ASSERT_HINT(unique_found == expected, query + " ~"s + to_string(max_edits));
+        }
+    }
+}
+
+void TestPrefixWalkMatchesBruteForce() {
+    mt19937 generator(9);
+    TermDictionary dictionary;
+    const auto words = MakeWords(dictionary, 3000, generator);
+    for (int q = 0; q < 200; ++q) {
+        const string& word = words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)];
+        const string prefix = word.substr(0, uniform_int_distribution<size_t>(0, word.size())(generator));
+        vector<string> found;
+        dictionary.ForEachWithPrefix(prefix, [&](int term_id) {
+            found.emplace_back(dictionary.GetWord(term_id));
+            return true;
+        });
+        // Breadth-first: shorter words first, byte order within a length
+        const auto is_shorter = [](const string& lhs, const string& rhs) {
+            return lhs.size() != rhs.size() ? lhs.size() < rhs.size() : lhs < rhs;
+        };
+        set<string, decltype(is_shorter)> expected(is_shorter);
+        for (const string& candidate : words) {
+            if (candidate.starts_with(prefix)) {
+                expected.insert(candidate);
+            }
+        }
+        ASSERT_HINT(found == vector<string>(expected.begin(), expected.end()), prefix);
+    }
+}
+
+void TestVisitorStopsWalk() {
+    TermDictionary dictionary;
+    for (const string& word : { "cat"s, "cap"s, "car"s, "cot"s, "cut"s }) {
+        dictionary.Add(word);
+    }
+    int visited = 0;
+    dictionary.ForEachWithPrefix("ca"s, [&visited](int) {
+        return ++visited < 2;
+    });
+    ASSERT_EQUAL(visited, 2);
+    visited = 0;
+    dictionary.ForEachWithinDistance("cat"s, 1, [&visited](int, int) {
+        return ++visited < 3;
+    });
+    ASSERT_EQUAL(visited, 3);
+}
+
+void TestFuzzyWalkStepBound() {
+    mt19937 generator(13);
+    TermDictionary dictionary;
+    const auto words = MakeWords(dictionary, 5000, generator);
+    const auto count_matches = [&dictionary](const string& word, size_t max_steps, bool& is_complete) {
+        size_t count = 0;
+        is_complete = dictionary.ForEachWithinDistance(word, 2, [&count](int, int) {
+            ++count;
+            return true;
+        }, max_steps);
+        return count;
+    };
+    bool is_complete = false;
+    const size_t all = count_matches(words[0], SIZE_MAX, is_complete);
+    ASSERT(is_complete);
+    const size_t bounded = count_matches(words[0], 50, is_complete);
+    ASSERT(!is_complete);
+    ASSERT(bounded < all);
+    // A visitor stopping the walk is not a cut walk
+    ASSERT(dictionary.ForEachWithinDistance(words[0], 2, [](int, int) { return false; }));
+}
+
+vector<int> GetIds(const vector<Document>& documents) {
+    vector<int> ids;
+    for (const Document& document : documents) {
+        ids.push_back(document.id);
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void TestFuzzyQueriesCountCodePoints() {
+    SearchServer search_server("и"s);
+    search_server.AddDocument(1, "коты"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "кит"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "кто"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(4, "котята"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(GetIds(search_server.FindTopDocuments("кот~"s)) == vector<int>({ 1, 2 }));
+    ASSERT(GetIds(search_server.FindTopDocuments("кот~2"s)) == vector<int>({ 1, 2, 3 }));
+    ASSERT(GetIds(search_server.FindTopDocuments("кот~1 -кит"s)) == vector<int>({ 1 }));
+    ASSERT(GetIds(search_server.FindTopDocuments("кот*"s)) == vector<int>({ 1, 4 }));
+}
+
+void TestMinusPatternsAreNotCapped() {
+    SearchServer search_server(""s);
+    const int count = static_cast<int>(MAX_QUERY_TERM_EXPANSIONS) * 3;
+    // Every "w" word has three letters, so all of them are within two edits of "ww" as well
+    for (int id = 0; id < count; ++id) {
+        const string word = "w"s + static_cast<char>('a' + id / 26) + static_cast<char>('a' + id % 26);
+        search_server.AddDocument(id, "common "s + word, DocumentStatus::ACTUAL, { 1 });
+    }
+    search_server.AddDocument(count, "common"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(GetIds(search_server.FindTopDocuments("common -w*"s)) == vector<int>({ count }));
+    ASSERT(GetIds(search_server.FindTopDocuments("common -ww~2"s)) == vector<int>({ count }));
+    const string query = "common -w*"s;
+    for (int id = 0; id < count; ++id) {
+        ASSERT(get<0>(search_server.MatchDocument(query, id)).empty());
+    }
+    ASSERT(get<0>(search_server.MatchDocument(query, count)) == vector<string_view>({ "common"sv }));
+}
+
+void TestExpansionsKeepClosestTerms() {
+    SearchServer search_server(""s);
+    // 75 words within two edits of "zzz" that all sort before it
+    int id = 0;
+    for (char first = 'a'; first <= 'y'; ++first) {
+        for (char second = 'a'; second <= 'c'; ++second) {
+            search_server.AddDocument(id++, string{ first, second, 'z' }, DocumentStatus::ACTUAL, { 1 });
+        }
+    }
+    search_server.AddDocument(1000, "zzz"s, DocumentStatus::ACTUAL, { 10 });
+    search_server.AddDocument(1001, "zzy"s, DocumentStatus::ACTUAL, { 9 });
+    const string fuzzy_query = "zzz~2"s;
+    ASSERT(get<0>(search_server.MatchDocument(fuzzy_query, 1000)) == vector<string_view>({ "zzz"sv }));
+    ASSERT(get<0>(search_server.MatchDocument(fuzzy_query, 1001)) == vector<string_view>({ "zzy"sv }));
+    const auto documents = search_server.FindTopDocuments(fuzzy_query);
+    ASSERT(!documents.empty());
+    ASSERT_EQUAL(documents[0].id, 1000);
+
+    // Prefix completions compete by document frequency, the exact word always stays
+    for (int i = 0; i < 100; ++i) {
+        search_server.AddDocument(2000 + i, "pa"s + to_string(10 + i), DocumentStatus::ACTUAL, { 1 });
+    }
+    for (int i = 0; i < 5; ++i) {
+        search_server.AddDocument(3000 + i, "pz99"s, DocumentStatus::ACTUAL, { 1 });
+    }
+    search_server.AddDocument(4000, "pa"s, DocumentStatus::ACTUAL, { 1 });
+    const string prefix_query = "pa*"s;
+    ASSERT(get<0>(search_server.MatchDocument(prefix_query, 4000)) == vector<string_view>({ "pa"sv }));
+    ASSERT(get<0>(search_server.MatchDocument("p*"s, 3000)) == vector<string_view>({ "pz99"sv }));
+    size_t matched = 0;
+    for (int i = 0; i < 100; ++i) {
+        matched += get<0>(search_server.MatchDocument(prefix_query, 2000 + i)).size();
+    }
+    ASSERT_EQUAL(matched, MAX_QUERY_TERM_EXPANSIONS - 1);
+}
+
+void TestEscapedSuffixesSearchLiteralWords() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "x* note"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "xylophone c~2 note"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "xa note c"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(GetIds(search_server.FindTopDocuments("x*"s)) == vector<int>({ 1, 2, 3 }));
+    ASSERT(GetIds(search_server.FindTopDocuments("x\\*"s)) == vector<int>({ 1 }));
+    ASSERT(GetIds(search_server.FindTopDocuments("c\\~2"s)) == vector<int>({ 2 }));
+    ASSERT(GetIds(search_server.FindTopDocuments("note -x\\*"s)) == vector<int>({ 2, 3 }));
+    ASSERT(search_server.FindTopDocuments("missing\\*"s).empty());
+
+    const string query = "x\\* c\\~2"s;
+    const auto [words, status] = search_server.MatchDocument(query, 1);
+    ASSERT(vector<string>(words.begin(), words.end()) == vector<string>({ "x*"s }));
+}
+
+}  // namespace
+
+void TestTermDictionary(TestRunner& runner) {
+    RUN_TEST(runner, TestFuzzyWalkMatchesBruteForce);
+    RUN_TEST(runner, TestPrefixWalkMatchesBruteForce);
+    RUN_TEST(runner, TestVisitorStopsWalk);
+    RUN_TEST(runner, TestFuzzyWalkStepBound);
+    RUN_TEST(runner, TestFuzzyQueriesCountCodePoints);
+    RUN_TEST(runner, TestMinusPatternsAreNotCapped);
+    RUN_TEST(runner, TestExpansionsKeepClosestTerms);
+    RUN_TEST(runner, TestEscapedSuffixesSearchLiteralWords);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "document.h"
+
+// Not derived from std::exception, so ASSERT_THROWS(..., std::exception) cannot swallow a failed assertion
+struct TestFailure {
+    std::string message;
+};
+
+inline void AssertImpl(bool value, const std::string& expr_str, const std::string& file, const std::string& func,
+    unsigned line, const std::string& hint) {
+    if (!value) {
+        std::ostringstream out;
+        out << file << "(" << line << "): " << func << ": ASSERT(" << expr_str << ") failed.";
+        if (!hint.empty()) {
+            out << " Hint: " << hint;
+        }
+        throw TestFailure{ out.str() };
+    }
+}
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& t, const U& u, const std::string& t_str, const std::string& u_str,
+    const std::string& file, const std::string& func, unsigned line, const std::string& hint) {
+    if (t != u) {
+        std::ostringstream out;
+        out << file << "(" << line << "): " << func << ": ASSERT_EQUAL(" << t_str << ", " << u_str
+            << ") failed: " << t << " != " << u << ".";
+        if (!hint.empty()) {
+            out << " Hint: " << hint;
+        }
+        throw TestFailure{ out.str() };
+    }
+}
+
+// Tied documents may legitimately come in a different order, so only relevance and rating are compared
+inline void AssertSameRankingImpl(const std::vector<Document>& expected, const std::vector<Document>& actual,
+    const std::string& file, const std::string& func, unsigned line, const std::string& hint) {
+    AssertEqualImpl(expected.size(), actual.size(), "expected.size()", "actual.size()", file, func, line, hint);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        AssertImpl(std::abs(expected[i].relevance - actual[i].relevance) < 1e-9 && expected[i].rating == actual[i].rating,
+            "same relevance and rating at position " + std::to_string(i), file, func, line, hint);
+    }
+}
+
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, std::string())
+#define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, std::string())
+#define ASSERT_EQUAL_HINT(a, b, hint) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+#define ASSERT_SAME_RANKING(expected, actual) \
+    AssertSameRankingImpl((expected), (actual), __FILE__, __FUNCTION__, __LINE__, std::string())
+#define ASSERT_SAME_RANKING_HINT(expected, actual, hint) \
+    AssertSameRankingImpl((expected), (actual), __FILE__, __FUNCTION__, __LINE__, (hint))
+#define ASSERT_THROWS(expr, exception_type) \
+    do { \
+        bool thrown = false; \
+        try { \
+            expr; \
+        } \
+        catch (const exception_type&) { \
+            thrown = true; \
+        } \
+        AssertImpl(thrown, #expr " throws " #exception_type, __FILE__, __FUNCTION__, __LINE__, std::string()); \
+    } while (false)
+
+class TestRunner {
+public:
+    template <typename TestFunc>
+    void Run(TestFunc func, const std::string& test_name) {
+        try {
+            func();
+            std::cerr << test_name << " OK" << std::endl;
+        }
+        catch (const TestFailure& failure) {
+            ++fail_count_;
+            std::cerr << test_name << " fail: " << failure.message << std::endl;
+        }
+        catch (const std::exception& e) {
+            ++fail_count_;
+            std::cerr << test_name << " fail: unexpected exception: " << e.what() << std::endl;
+        }
+    }
+
+    int GetFailCount() const {
+        return fail_count_;
+    }
+
+private:
+    int fail_count_ = 0;
+};
+
+#define RUN_TEST(runner, func) (runner).Run((func), #func)
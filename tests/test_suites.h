@@ -0,0 +1,16 @@
+#pragma once
+
+#include "test_framework.h"
+
+// Process shards fork, so their suite runs before anything starts parallel algorithm threads
+void TestShardedSearchServer(TestRunner& runner);
+void TestDocumentLoader(TestRunner& runner);
+void TestUpdateDocument(TestRunner& runner);
+void TestDocumentTable(TestRunner& runner);
+void TestTermDictionary(TestRunner& runner);
+void TestQueryLimits(TestRunner& runner);
+void TestMemoryBudget(TestRunner& runner);
+void TestConcurrentMap(TestRunner& runner);
+
+// Runs in search_server_profiling_tests, which links a core built with SEARCH_SERVER_PROFILING
+void TestQueryProfile(TestRunner& runner);
@@ -0,0 +1,136 @@
+#include "test_suites.h"
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on"s;
+
+struct StoredDocument {
+    string text;
+    DocumentStatus status;
+    vector<int> ratings;
+};
+
+map<string, double> ToMap(const WordFrequencies& word_frequencies) {
+    map<string, double> result;
+    for (const auto [word, frequency] : word_frequencies) {
+        result.emplace(word, frequency);
+    }
+    return result;
+}
+
+string MakeText(mt19937& generator, int vocabulary_size) {
+    string text;
+    for (int i = uniform_int_distribution(0, 8)(generator); i > 0; --i) {
+        text += "w"s + to_string(uniform_int_distribution(0, vocabulary_size - 1)(generator)) + (i % 3 == 0 ? " on "s : " "s);
+    }
+    return text;
+}
+
+// The reference server rebuilds every changed document from scratch
+void Reindex(SearchServer& reference, int id, const StoredDocument& document) {
+    reference.RemoveDocument(id);
+    reference.AddDocument(id, document.text, document.status, document.ratings);
+}
+
+void AssertSameIndex(const SearchServer& reference, const SearchServer& updated, int vocabulary_size) {
+    ASSERT_EQUAL(updated.GetDocumentCount(), reference.GetDocumentCount());
+    ASSERT(vector<int>(updated.begin(), updated.end()) == vector<int>(reference.begin(), reference.end()));
+    for (const int id : reference) {
+        ASSERT_HINT(ToMap(updated.GetWordFrequencies(id)) == ToMap(reference.GetWordFrequencies(id)), to_string(id));
+    }
+    for (int q = 0; q < vocabulary_size; ++q) {
+        const string query = "w"s + to_string(q) + " w"s + to_string((q * 7) % vocabulary_size) + " -w"s + to_string((q + 1) % vocabulary_size);
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED }) {
+            ASSERT_SAME_RANKING_HINT(reference.FindTopDocuments(query, status), updated.FindTopDocuments(query, status), query);
+        }
+    }
+}
+
+void TestUpdatesMatchRemoveAndAdd() {
+    constexpr int vocabulary_size = 60;
+    mt19937 generator(5);
+    SearchServer reference(STOP_WORDS);
+    SearchServer updated(STOP_WORDS);
+    map<int, StoredDocument> documents;
+    for (int id = 0; id < 200; ++id) {
+        StoredDocument document{ MakeText(generator, vocabulary_size), DocumentStatus::ACTUAL, { id % 9 - 4 } };
+        reference.AddDocument(id, document.text, document.status, document.ratings);
+        updated.AddDocument(id, document.text, document.status, document.ratings);
+        documents.emplace(id, move(document));
+    }
+
+    for (int step = 0; step < 3000; ++step) {
+        const int id = uniform_int_distribution(0, 199)(generator);
+        StoredDocument& document = documents.at(id);
+        switch (uniform_int_distribution(0, 3)(generator)) {
+        case 0:
+        case 1:
+            // Often keeps most of the words, so the merge sees inserts, removals and changed frequencies together
+            document.text = step % 2 ? MakeText(generator, vocabulary_size) : document.text + " "s + MakeText(generator, 5);
+            document.status = static_cast<DocumentStatus>(uniform_int_distribution(0, 2)(generator));
+            document.ratings = { uniform_int_distribution(-5, 5)(generator), 3 };
+            updated.UpdateDocument(id, document.text, document.status, document.ratings);
+            break;
+        case 2:
+            document.status = static_cast<DocumentStatus>(uniform_int_distribution(0, 2)(generator));
+            updated.SetStatus(id, document.status);
+            break;
+        default:
+            document.ratings = { uniform_int_distribution(-20, 20)(generator) };
+            updated.SetRating(id, document.ratings[0]);
+            break;
+        }
+        Reindex(reference, id, document);
+        if (step % 500 == 0) {
+            AssertSameIndex(reference, updated, vocabulary_size);
+        }
+    }
+    AssertSameIndex(reference, updated, vocabulary_size);
+    updated.Compact();
+    AssertSameIndex(reference, updated, vocabulary_size);
+}
+
+void TestUpdateToStopWordsOnly() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.UpdateDocument(1, "in and on"s, DocumentStatus::ACTUAL, { 2 });
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1);
+    ASSERT(search_server.GetWordFrequencies(1).empty());
+    ASSERT(search_server.FindTopDocuments("cat city"s).empty());
+
+    search_server.UpdateDocument(1, "city cat cat"s, DocumentStatus::BANNED, { 6 });
+    ASSERT(search_server.FindTopDocuments("cat"s).empty());
+    const auto documents = search_server.FindTopDocuments("cat"s, DocumentStatus::BANNED);
+    ASSERT_EQUAL(documents.size(), 1u);
+    ASSERT_EQUAL(documents[0].rating, 6);
+    ASSERT(ToMap(search_server.GetWordFrequencies(1)) == (map<string, double>{ { "cat"s, 2.0 / 3 }, { "city"s, 1.0 / 3 } }));
+}
+
+void TestUpdatesOfUnknownDocumentsThrow() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_THROWS(search_server.UpdateDocument(2, "dog"s, DocumentStatus::ACTUAL, { 1 }), out_of_range);
+    ASSERT_THROWS(search_server.SetStatus(2, DocumentStatus::BANNED), out_of_range);
+    ASSERT_THROWS(search_server.SetRating(2, 5), out_of_range);
+    ASSERT_THROWS(search_server.UpdateDocument(1, "bad \x01 word"s, DocumentStatus::ACTUAL, { 1 }), invalid_argument);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1);
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(), 1u);
+}
+
+}  // namespace
+
+void TestUpdateDocument(TestRunner& runner) {
+    RUN_TEST(runner, TestUpdatesMatchRemoveAndAdd);
+    RUN_TEST(runner, TestUpdateToStopWordsOnly);
+    RUN_TEST(runner, TestUpdatesOfUnknownDocumentsThrow);
+}